@@ -0,0 +1,30 @@
+#pragma once
+
+// Counts every global operator new, for the benchmarks that report heap
+// allocations. Include it from exactly one file per program: it replaces
+// the global allocation functions.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+inline std::atomic<size_t> allocationCount{0};
+
+// The replacements stay out of line: once inlined, GCC matches their malloc()
+// and free() against new and delete and reports -Wmismatched-new-delete.
+__attribute__((noinline)) void* operator new(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size == 0 ? 1 : size)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+__attribute__((noinline)) void operator delete(void* memory, size_t) noexcept {
+    std::free(memory);
+}
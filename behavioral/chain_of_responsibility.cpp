@@ -1,12 +1,44 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
 #include <iostream>
 #include <memory>
+#include <numeric>
+#include <span>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <vector>
+
+// A single (issue, severity) request, used by the batch and pipelined modes
+struct SupportRequest {
+    std::string issue;
+    int severity = 0;
+};
 
 // Step 1: Define the Handler interface
+// A handler that declares the severities it owns with claimSeverities() can be
+// routed without a virtual call per hop: the batch, frozen and pipelined paths
+// test the range inline. canHandle() must agree with the declared range.
+// A handler that declares nothing routes only through handleRequest(), and
+// every fast path hands the requests that reach it to that function.
 class SupportHandler {
 protected:
     std::shared_ptr<SupportHandler> nextHandler;
 
+    void claimSeverities(int low, int high) {
+        claimLow = low;
+        claimHigh = high;
+        declared = true;
+    }
+
+private:
+    int claimLow = 0;
+    int claimHigh = -1;
+    bool declared = false;
+
 public:
     virtual ~SupportHandler() = default;
 
@@ -15,20 +47,94 @@ public:
         nextHandler = handler;
     }
 
+    std::shared_ptr<SupportHandler> getNextHandler() const {
+        return nextHandler;
+    }
+
+    bool declaresSeverities() const {
+        return declared;
+    }
+
+    // Non-virtual ownership test against the declared range
+    bool claims(int severity) const {
+        return severity >= claimLow && severity <= claimHigh;
+    }
+
+    // Severity predicate: does this handler take ownership of the request?
+    virtual bool canHandle(int severity) const {
+        return claims(severity);
+    }
+
+    // The work done once this handler owns the request
+    virtual void handle(const std::string& /*issue*/) {}
+
     // Handle request or pass it to the next handler
     virtual void handleRequest(const std::string& issue, int severity) {
-        if (nextHandler) {
+        if (canHandle(severity)) {
+            handle(issue);
+        } else if (nextHandler) {
             nextHandler->handleRequest(issue, severity);
         }
     }
+
+    // Handle a burst of requests: partition the indices once per handler
+    // against its declared range, handle the ones it owns, then forward the
+    // remainder to the next handler in a single call. The partition is
+    // branchless and stable, so the requests themselves never move and each
+    // handler sees its requests in arrival order. Like the frozen table, the
+    // burst skips "Escalating" notices.
+    void handleBatch(std::span<const SupportRequest> requests) {
+        std::vector<uint32_t> indices(2 * requests.size());
+        std::span<uint32_t> order(indices.data(), requests.size());
+        std::iota(order.begin(), order.end(), 0u);
+        routeBatch(requests, order, std::span<uint32_t>(indices).subspan(requests.size()));
+    }
+
+private:
+    // Handles the requests in `order` it owns and compacts the rest, still in
+    // arrival order, to the front of `order` for the next handler. A handler
+    // without a declared range takes the rest through handleRequest().
+    void routeBatch(std::span<const SupportRequest> requests, std::span<uint32_t> order,
+                    std::span<uint32_t> claimed) {
+        if (!declared) {
+            for (uint32_t index : order) {
+                handleRequest(requests[index].issue, requests[index].severity);
+            }
+            return;
+        }
+        size_t owned = 0;
+        size_t unclaimed = 0;
+        for (size_t position = 0; position < order.size(); ++position) {
+            uint32_t index = order[position];
+            bool mine = claims(requests[index].severity);
+            claimed[owned] = index;
+            order[unclaimed] = index;
+            owned += mine;
+            unclaimed += !mine;
+        }
+        for (size_t k = 0; k < owned; ++k) {
+            handle(requests[claimed[k]].issue);
+        }
+        if (nextHandler && unclaimed > 0) {
+            nextHandler->routeBatch(requests, order.first(unclaimed), claimed);
+        }
+    }
 };
 
 // Step 2: Create concrete handlers
 class BasicSupport : public SupportHandler {
 public:
+    BasicSupport() {
+        claimSeverities(INT_MIN, 1);
+    }
+
+    void handle(const std::string& issue) override {
+        std::cout << "Basic Support: Handling issue \"" << issue << "\"." << std::endl;
+    }
+
     void handleRequest(const std::string& issue, int severity) override {
-        if (severity <= 1) {
-            std::cout << "Basic Support: Handling issue \"" << issue << "\"." << std::endl;
+        if (canHandle(severity)) {
+            handle(issue);
         } else {
             std::cout << "Basic Support: Escalating issue \"" << issue << "\"." << std::endl;
             SupportHandler::handleRequest(issue, severity);
@@ -38,9 +144,17 @@ public:
 
 class AdvancedSupport : public SupportHandler {
 public:
+    AdvancedSupport() {
+        claimSeverities(2, 2);
+    }
+
+    void handle(const std::string& issue) override {
+        std::cout << "Advanced Support: Handling issue \"" << issue << "\"." << std::endl;
+    }
+
     void handleRequest(const std::string& issue, int severity) override {
-        if (severity == 2) {
-            std::cout << "Advanced Support: Handling issue \"" << issue << "\"." << std::endl;
+        if (canHandle(severity)) {
+            handle(issue);
         } else {
             std::cout << "Advanced Support: Escalating issue \"" << issue << "\"." << std::endl;
             SupportHandler::handleRequest(issue, severity);
@@ -50,17 +164,499 @@ public:
 
 class ManagerSupport : public SupportHandler {
 public:
+    ManagerSupport() {
+        claimSeverities(3, INT_MAX);
+    }
+
+    void handle(const std::string& issue) override {
+        std::cout << "Manager Support: Handling critical issue \"" << issue << "\"." << std::endl;
+    }
+
     void handleRequest(const std::string& issue, int severity) override {
-        if (severity >= 3) {
-            std::cout << "Manager Support: Handling critical issue \"" << issue << "\"." << std::endl;
+        if (canHandle(severity)) {
+            handle(issue);
         } else {
             SupportHandler::handleRequest(issue, severity);
         }
     }
 };
 
-// Step 3: Set up the chain of responsibility
-int main() {
+// Step 3: Freeze a linked chain into a flat severity -> handler jump table
+// Each severity in [minSeverity, maxSeverity] is resolved against the chain once,
+// up front, so dispatch becomes a single indexed load plus one virtual call.
+// A slot is frozen only if every handler up to its owner declares its range;
+// a handler without one may take the request in handleRequest(), so slots
+// that reach it, slots nobody claims, and severities outside the frozen range
+// fall back to the linked walk.
+// The frozen path skips the per-hop "Escalating" notices: those hops are
+// exactly what freezing removes, and the handler that ends up owning each
+// request is the same one the linked walk would reach.
+class FrozenChain {
+private:
+    std::shared_ptr<SupportHandler> head;
+    std::vector<std::shared_ptr<SupportHandler>> handlers;  // Keeps the chain alive
+    std::vector<SupportHandler*> table;                     // nullptr = resolve by the linked walk
+    int minSeverity;
+
+public:
+    FrozenChain(std::shared_ptr<SupportHandler> head, int minSeverity, int maxSeverity)
+        : head(head), minSeverity(minSeverity) {
+        if (maxSeverity < minSeverity) {
+            throw std::invalid_argument("FrozenChain: maxSeverity < minSeverity");
+        }
+
+        for (auto handler = head; handler; handler = handler->getNextHandler()) {
+            handlers.push_back(handler);
+        }
+
+        table.assign(static_cast<size_t>(static_cast<int64_t>(maxSeverity) - minSeverity) + 1, nullptr);
+        for (size_t slot = 0; slot < table.size(); ++slot) {
+            int severity = minSeverity + static_cast<int>(slot);
+            for (auto& handler : handlers) {
+                if (!handler->declaresSeverities()) {
+                    break;
+                }
+                if (handler->claims(severity)) {
+                    table[slot] = handler.get();
+                    break;
+                }
+            }
+        }
+    }
+
+    void handleRequest(const std::string& issue, int severity) const {
+        if (severity >= minSeverity) {
+            // Widened so extreme severities cannot overflow the subtraction
+            auto slot = static_cast<size_t>(static_cast<int64_t>(severity) - minSeverity);
+            if (slot < table.size() && table[slot]) {
+                table[slot]->handle(issue);
+                return;
+            }
+        }
+        if (head) {
+            head->handleRequest(issue, severity);
+        }
+    }
+
+    size_t depth() const {
+        return handlers.size();
+    }
+};
+
+// Step 4: Benchmark the linked walk against the frozen table
+// CountingSupport owns exactly one severity and does no I/O, so the timing
+// measures dispatch rather than std::cout.
+class CountingSupport : public SupportHandler {
+public:
+    size_t handled = 0;
+
+    explicit CountingSupport(int severity) {
+        claimSeverities(severity, severity);
+    }
+
+    void handle(const std::string& issue) override {
+        handled += issue.size();
+    }
+};
+
+void benchmarkFrozenChain() {
+    const std::string issue = "Benchmark issue";
+    const size_t requestCount = 1000000;
+
+    std::cout << "depth  linked ns/req  frozen ns/req  speedup" << std::endl;
+    for (int depth : {3, 8, 16, 32, 64, 128, 256}) {
+        std::vector<std::shared_ptr<CountingSupport>> chain;
+        for (int severity = 0; severity < depth; ++severity) {
+            chain.push_back(std::make_shared<CountingSupport>(severity));
+            if (severity > 0) {
+                chain[severity - 1]->setNextHandler(chain[severity]);
+            }
+        }
+
+        std::vector<int> severities(requestCount);
+        unsigned seed = 12345;
+        for (auto& severity : severities) {
+            seed = seed * 1103515245u + 12345u;
+            severity = static_cast<int>((seed >> 16) % static_cast<unsigned>(depth));
+        }
+
+        auto countHandled = [&chain]() {
+            size_t total = 0;
+            for (auto& handler : chain) {
+                total += handler->handled;
+                handler->handled = 0;
+            }
+            return total;
+        };
+
+        auto start = std::chrono::steady_clock::now();
+        for (int severity : severities) {
+            chain.front()->handleRequest(issue, severity);
+        }
+        auto linkedTime = std::chrono::steady_clock::now() - start;
+        size_t linkedHandled = countHandled();
+
+        FrozenChain frozen(chain.front(), 0, depth - 1);
+        start = std::chrono::steady_clock::now();
+        for (int severity : severities) {
+            frozen.handleRequest(issue, severity);
+        }
+        auto frozenTime = std::chrono::steady_clock::now() - start;
+        size_t frozenHandled = countHandled();
+
+        if (linkedHandled != frozenHandled) {
+            std::cout << "Mismatch at depth " << depth << "!" << std::endl;
+        }
+
+        double linkedNs = std::chrono::duration<double, std::nano>(linkedTime).count() / requestCount;
+        double frozenNs = std::chrono::duration<double, std::nano>(frozenTime).count() / requestCount;
+        std::cout << depth << "\t" << linkedNs << "\t\t" << frozenNs << "\t\t"
+                  << linkedNs / frozenNs << "x" << std::endl;
+    }
+}
+
+void benchmarkBatchRouting() {
+    const size_t batchSize = 50000;
+    const int rounds = 20;
+
+    std::cout << "\ndepth  per-request ns/req  batch ns/req  speedup" << std::endl;
+    for (int depth : {3, 8, 32, 128}) {
+        std::vector<std::shared_ptr<CountingSupport>> chain;
+        for (int severity = 0; severity < depth; ++severity) {
+            chain.push_back(std::make_shared<CountingSupport>(severity));
+            if (severity > 0) {
+                chain[severity - 1]->setNextHandler(chain[severity]);
+            }
+        }
+
+        std::vector<SupportRequest> batch(batchSize);
+        unsigned seed = 12345;
+        for (auto& request : batch) {
+            seed = seed * 1103515245u + 12345u;
+            request.issue = "Burst issue";
+            request.severity = static_cast<int>((seed >> 16) % static_cast<unsigned>(depth));
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round < rounds; ++round) {
+            for (const auto& request : batch) {
+                chain.front()->handleRequest(request.issue, request.severity);
+            }
+        }
+        auto perRequestTime = std::chrono::steady_clock::now() - start;
+
+        // handleBatch leaves the batch as it was, so every round routes the
+        // same unsorted arrival order
+        start = std::chrono::steady_clock::now();
+        for (int round = 0; round < rounds; ++round) {
+            chain.front()->handleBatch(batch);
+        }
+        auto batchTime = std::chrono::steady_clock::now() - start;
+
+        double total = static_cast<double>(batchSize) * rounds;
+        double perRequestNs = std::chrono::duration<double, std::nano>(perRequestTime).count() / total;
+        double batchNs = std::chrono::duration<double, std::nano>(batchTime).count() / total;
+        std::cout << depth << "\t" << perRequestNs << "\t\t\t" << batchNs << "\t\t"
+                  << perRequestNs / batchNs << "x" << std::endl;
+    }
+}
+
+// Step 5: Run the chain as a pipeline, one worker thread per handler
+// Stages are connected by bounded single-producer/single-consumer rings, so
+// the submitting thread only ever touches the first stage's queue and a slow
+// handler at the end of the chain never blocks ingestion until the queues
+// in front of it fill up. An idle thread spins briefly, then sleeps in
+// std::atomic::wait until the other side makes progress.
+class Parker {
+private:
+    std::atomic<bool> sleeping{false};
+
+public:
+    // Return once ready() holds; ready() is re-checked after every wake-up
+    template <typename Ready>
+    void waitUntil(Ready ready) {
+        for (int spin = 0; spin < 128; ++spin) {
+            if (ready()) {
+                return;
+            }
+        }
+        while (true) {
+            sleeping.store(true, std::memory_order_relaxed);
+            // Either the waker's load in wake() sees us sleeping, or ready()
+            // sees the progress it published before calling wake()
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (ready()) {
+                sleeping.store(false, std::memory_order_relaxed);
+                return;
+            }
+            sleeping.wait(true, std::memory_order_acquire);
+        }
+    }
+
+    // Call after publishing progress with a seq_cst read-modify-write; costs
+    // one load, and a syscall only when a thread sleeps
+    void wake() {
+        if (sleeping.load(std::memory_order_seq_cst)) {
+            sleeping.store(false, std::memory_order_release);
+            sleeping.notify_one();
+        }
+    }
+};
+
+template <typename T>
+class SpscQueue {
+private:
+    std::vector<T> slots;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head{0};  // Next slot to pop (consumer-owned)
+    alignas(64) std::atomic<size_t> tail{0};  // Next slot to push (producer-owned)
+    Parker consumer;  // Sleeps while the queue is empty
+    Parker producer;  // Sleeps while the queue is full
+
+public:
+    explicit SpscQueue(size_t capacity) {
+        size_t rounded = 1;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+        slots.resize(rounded);
+        mask = rounded - 1;
+    }
+
+    bool tryPush(T&& item) {
+        size_t currentTail = tail.load(std::memory_order_relaxed);
+        if (currentTail - head.load(std::memory_order_acquire) == slots.size()) {
+            return false;
+        }
+        slots[currentTail & mask] = std::move(item);
+        tail.exchange(currentTail + 1);
+        consumer.wake();
+        return true;
+    }
+
+    void push(T&& item) {
+        producer.waitUntil([&] { return tryPush(std::move(item)); });
+    }
+
+    bool tryPop(T& item) {
+        size_t currentHead = head.load(std::memory_order_relaxed);
+        if (currentHead == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = std::move(slots[currentHead & mask]);
+        head.exchange(currentHead + 1);
+        producer.wake();
+        return true;
+    }
+
+    // Wait for an item; returns false once the queue is empty and running is
+    // cleared (call wakeConsumer() after clearing it)
+    bool pop(T& item, const std::atomic<bool>& running) {
+        bool popped = false;
+        consumer.waitUntil([&] {
+            popped = tryPop(item);
+            return popped || !running.load(std::memory_order_acquire);
+        });
+        return popped;
+    }
+
+    void wakeConsumer() {
+        consumer.wake();
+    }
+
+    size_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+};
+
+class SupportPipeline {
+public:
+    struct StageStats {
+        size_t queueDepth;
+        size_t handled;
+        size_t forwarded;
+    };
+
+private:
+    struct Stage {
+        std::shared_ptr<SupportHandler> handler;
+        SpscQueue<SupportRequest> inbox;
+        std::atomic<size_t> handled{0};
+        std::atomic<size_t> forwarded{0};
+        std::thread worker;
+
+        Stage(std::shared_ptr<SupportHandler> handler, size_t capacity)
+            : handler(std::move(handler)), inbox(capacity) {}
+    };
+
+    std::vector<std::unique_ptr<Stage>> stages;
+    std::atomic<bool> running{true};
+    std::atomic<size_t> completed{0};
+    std::atomic<size_t> unhandled{0};
+    size_t submitted = 0;
+    mutable Parker drainer;  // The thread waiting in drain()
+
+    void runStage(size_t index) {
+        Stage& stage = *stages[index];
+        Stage* next = index + 1 < stages.size() ? stages[index + 1].get() : nullptr;
+        SupportRequest request;
+
+        bool declared = stage.handler->declaresSeverities();
+        while (stage.inbox.pop(request, running)) {
+            if (!declared) {
+                // No declared range: the handler routes it, walking the rest of
+                // the chain itself, so the request leaves the pipeline here
+                stage.handler->handleRequest(request.issue, request.severity);
+                stage.handled.fetch_add(1, std::memory_order_relaxed);
+                completed.fetch_add(1);
+                drainer.wake();
+            } else if (stage.handler->claims(request.severity)) {
+                stage.handler->handle(request.issue);
+                stage.handled.fetch_add(1, std::memory_order_relaxed);
+                completed.fetch_add(1);
+                drainer.wake();
+            } else if (next) {
+                next->inbox.push(std::move(request));
+                stage.forwarded.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                unhandled.fetch_add(1, std::memory_order_relaxed);
+                completed.fetch_add(1);
+                drainer.wake();
+            }
+        }
+    }
+
+public:
+    // Snapshot the linked chain starting at head; every handler becomes a stage.
+    explicit SupportPipeline(std::shared_ptr<SupportHandler> head, size_t queueCapacity = 1024) {
+        for (auto handler = head; handler; handler = handler->getNextHandler()) {
+            stages.push_back(std::make_unique<Stage>(handler, queueCapacity));
+        }
+        for (size_t index = 0; index < stages.size(); ++index) {
+            stages[index]->worker = std::thread(&SupportPipeline::runStage, this, index);
+        }
+    }
+
+    ~SupportPipeline() {
+        shutdown();
+    }
+
+    SupportPipeline(const SupportPipeline&) = delete;
+    SupportPipeline& operator=(const SupportPipeline&) = delete;
+
+    // Returns false instead of waiting when the first stage is full.
+    // Must be called from a single submitting thread.
+    bool trySubmit(std::string issue, int severity) {
+        if (stages.empty()) {
+            return false;
+        }
+        SupportRequest request{std::move(issue), severity};
+        if (!stages.front()->inbox.tryPush(std::move(request))) {
+            return false;
+        }
+        ++submitted;
+        return true;
+    }
+
+    void submit(std::string issue, int severity) {
+        if (stages.empty()) {
+            return;
+        }
+        stages.front()->inbox.push(SupportRequest{std::move(issue), severity});
+        ++submitted;
+    }
+
+    // Wait until every submitted request has been handled or fallen off the chain
+    void drain() const {
+        drainer.waitUntil([this] { return completed.load(std::memory_order_acquire) >= submitted; });
+    }
+
+    void shutdown() {
+        drain();
+        if (!running.exchange(false)) {
+            return;
+        }
+        for (auto& stage : stages) {
+            stage->inbox.wakeConsumer();
+        }
+        for (auto& stage : stages) {
+            if (stage->worker.joinable()) {
+                stage->worker.join();
+            }
+        }
+    }
+
+    std::vector<StageStats> stats() const {
+        std::vector<StageStats> result;
+        for (auto& stage : stages) {
+            result.push_back({stage->inbox.size(),
+                              stage->handled.load(std::memory_order_relaxed),
+                              stage->forwarded.load(std::memory_order_relaxed)});
+        }
+        return result;
+    }
+
+    size_t unhandledCount() const {
+        return unhandled.load(std::memory_order_relaxed);
+    }
+};
+
+// Step 6: Load generator for the pipelined chain
+void generateSupportLoad(size_t requestCount) {
+    auto basic = std::make_shared<CountingSupport>(1);
+    auto advanced = std::make_shared<CountingSupport>(2);
+    auto manager = std::make_shared<CountingSupport>(3);
+    basic->setNextHandler(advanced);
+    advanced->setNextHandler(manager);
+
+    SupportPipeline pipeline(basic, 4096);
+    std::vector<size_t> maxDepth(3, 0);
+    unsigned seed = 12345;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t request = 0; request < requestCount; ++request) {
+        seed = seed * 1103515245u + 12345u;
+        pipeline.submit("Load issue", 1 + static_cast<int>((seed >> 16) % 3));
+
+        if ((request & 0xFFFF) == 0) {
+            auto stats = pipeline.stats();
+            for (size_t stage = 0; stage < stats.size(); ++stage) {
+                maxDepth[stage] = std::max(maxDepth[stage], stats[stage].queueDepth);
+            }
+        }
+    }
+    auto ingestTime = std::chrono::steady_clock::now() - start;
+    pipeline.drain();
+    auto totalTime = std::chrono::steady_clock::now() - start;
+
+    double ingestSeconds = std::chrono::duration<double>(ingestTime).count();
+    double totalSeconds = std::chrono::duration<double>(totalTime).count();
+    std::cout << "Pipelined " << requestCount << " requests in " << totalSeconds << " s ("
+              << requestCount / totalSeconds / 1e6 << " M req/s, ingestion "
+              << requestCount / ingestSeconds / 1e6 << " M req/s)" << std::endl;
+
+    const char* names[] = {"Basic", "Advanced", "Manager"};
+    auto stats = pipeline.stats();
+    for (size_t stage = 0; stage < stats.size(); ++stage) {
+        std::cout << "  " << names[stage] << ": handled " << stats[stage].handled
+                  << " (" << stats[stage].handled / totalSeconds / 1e6 << " M/s), forwarded "
+                  << stats[stage].forwarded << ", max queue depth " << maxDepth[stage] << std::endl;
+    }
+    std::cout << "  Unhandled: " << pipeline.unhandledCount() << std::endl;
+}
+
+// Step 7: Set up the chain of responsibility
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        benchmarkFrozenChain();
+        benchmarkBatchRouting();
+        return 0;
+    }
+    if (argc > 1 && std::string(argv[1]) == "--load") {
+        generateSupportLoad(argc > 2 ? std::stoul(argv[2]) : 10000000);
+        return 0;
+    }
+
     // Create the support handlers
     auto basicSupport = std::make_shared<BasicSupport>();
     auto advancedSupport = std::make_shared<AdvancedSupport>();
@@ -70,7 +666,7 @@ int main() {
     basicSupport->setNextHandler(advancedSupport);
     advancedSupport->setNextHandler(managerSupport);
 
-    // Step 4: Test the chain with different requests
+    // Step 8: Test the chain with different requests
     std::cout << "Request 1: Minor issue (severity 1)" << std::endl;
     basicSupport->handleRequest("Minor issue", 1);
 
@@ -80,5 +676,35 @@ int main() {
     std::cout << "\nRequest 3: Critical issue (severity 3)" << std::endl;
     basicSupport->handleRequest("Critical issue", 3);
 
+    // Step 9: Freeze the chain and dispatch in one hop
+    FrozenChain frozen(basicSupport, 0, 3);
+
+    std::cout << "\nFrozen request: Advanced issue (severity 2)" << std::endl;
+    frozen.handleRequest("Advanced issue", 2);
+
+    std::cout << "\nFrozen request: Outage (severity 7, outside the table)" << std::endl;
+    frozen.handleRequest("Outage", 7);
+
+    // Step 10: Route a burst of requests in one call
+    std::vector<SupportRequest> burst = {
+        {"Password reset", 1}, {"Outage", 3}, {"Slow query", 2}, {"Typo on page", 1}};
+
+    std::cout << "\nBatch of " << burst.size() << " requests" << std::endl;
+    basicSupport->handleBatch(burst);
+
+    // Step 11: Run the same chain as a threaded pipeline
+    SupportPipeline pipeline(basicSupport);
+
+    std::cout << "\nPipelined request: Critical issue (severity 3)" << std::endl;
+    pipeline.submit("Critical issue", 3);
+    pipeline.drain();
+
+    auto stats = pipeline.stats();
+    std::cout << "Stage counters (handled/forwarded):";
+    for (auto& stage : stats) {
+        std::cout << " " << stage.handled << "/" << stage.forwarded;
+    }
+    std::cout << std::endl;
+
     return 0;
 }
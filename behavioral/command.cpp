@@ -1,6 +1,30 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
 #include <iostream>
+#include <memory>
+#include <new>
 #include <stack>
+#include <stdexcept>
 #include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "allocation_counter.h"
+
+class CommandJournal;
 
 // Step 1: Define the Command interface
 class Command {
@@ -8,33 +32,516 @@ public:
     virtual ~Command() = default;
     virtual void execute() = 0;
     virtual void undo() = 0;
+
+    // Absorb a command that ran right after this one, so that undoing this
+    // command reverts both. Returns false if the two cannot be combined.
+    virtual bool mergeWith(const Command& /*next*/) {
+        return false;
+    }
+
+    // Append the receiver edits made by execute() / undo() to a journal
+    virtual void record(CommandJournal& /*journal*/) const {}
+    virtual void recordUndo(CommandJournal& /*journal*/) const {}
+};
+
+// Step 2: Create the Receiver's storage (a chunked rope)
+// The text is kept as an implicit treap of string chunks ordered by position.
+// Every node caches the length of its subtree, so locating, inserting and
+// erasing at any offset costs O(log n) expected plus O(MaxChunk) for the
+// chunk that is touched, instead of O(n) for a flat std::string.
+class Rope {
+private:
+    static constexpr size_t MaxChunk = 1024;
+
+    struct Node {
+        std::string chunk;
+        size_t size;
+        uint32_t priority;
+        std::unique_ptr<Node> left, right;
+
+        Node(std::string chunk, uint32_t priority)
+            : chunk(std::move(chunk)), size(this->chunk.size()), priority(priority) {}
+    };
+
+    std::unique_ptr<Node> root;
+    uint32_t seed = 2463534242u;
+
+    uint32_t nextPriority() {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        return seed;
+    }
+
+    static size_t sizeOf(const std::unique_ptr<Node>& node) {
+        return node ? node->size : 0;
+    }
+
+    static void update(Node* node) {
+        node->size = node->chunk.size() + sizeOf(node->left) + sizeOf(node->right);
+    }
+
+    static std::unique_ptr<Node> merge(std::unique_ptr<Node> left, std::unique_ptr<Node> right) {
+        if (!left) return right;
+        if (!right) return left;
+        if (left->priority > right->priority) {
+            left->right = merge(std::move(left->right), std::move(right));
+            update(left.get());
+            return left;
+        }
+        right->left = merge(std::move(left), std::move(right->left));
+        update(right.get());
+        return right;
+    }
+
+    // Split into [0, pos) and [pos, size), cutting a chunk in two if needed
+    std::pair<std::unique_ptr<Node>, std::unique_ptr<Node>> split(std::unique_ptr<Node> node, size_t pos) {
+        if (!node) return {nullptr, nullptr};
+
+        size_t leftSize = sizeOf(node->left);
+        if (pos <= leftSize) {
+            auto [lower, upper] = split(std::move(node->left), pos);
+            node->left = std::move(upper);
+            update(node.get());
+            return {std::move(lower), std::move(node)};
+        }
+
+        size_t chunkEnd = leftSize + node->chunk.size();
+        if (pos >= chunkEnd) {
+            auto [lower, upper] = split(std::move(node->right), pos - chunkEnd);
+            node->right = std::move(lower);
+            update(node.get());
+            return {std::move(node), std::move(upper)};
+        }
+
+        // pos falls inside this chunk: keep the head here, move the tail into its own node
+        size_t offset = pos - leftSize;
+        auto tail = std::make_unique<Node>(node->chunk.substr(offset), nextPriority());
+        node->chunk.resize(offset);
+        auto upper = merge(std::move(tail), std::move(node->right));
+        update(node.get());
+        return {std::move(node), std::move(upper)};
+    }
+
+    // Fast path: grow an existing chunk in place when the text still fits
+    static bool insertIntoChunk(Node* node, size_t pos, const std::string& text) {
+        if (!node) return false;
+
+        size_t leftSize = sizeOf(node->left);
+        bool inserted;
+        if (pos < leftSize || (pos == leftSize && node->left && node->chunk.size() + text.size() > MaxChunk)) {
+            inserted = insertIntoChunk(node->left.get(), pos, text);
+        } else if (pos <= leftSize + node->chunk.size() && node->chunk.size() + text.size() <= MaxChunk) {
+            node->chunk.insert(pos - leftSize, text);
+            inserted = true;
+        } else if (pos >= leftSize + node->chunk.size()) {
+            inserted = insertIntoChunk(node->right.get(), pos - leftSize - node->chunk.size(), text);
+        } else {
+            inserted = false;
+        }
+
+        if (inserted) {
+            node->size += text.size();
+        }
+        return inserted;
+    }
+
+    // Fast path: shrink a single chunk in place when the range stays inside it
+    static bool eraseFromChunk(Node* node, size_t pos, size_t count, std::string* removed) {
+        if (!node) return false;
+
+        size_t leftSize = sizeOf(node->left);
+        size_t chunkEnd = leftSize + node->chunk.size();
+        bool erased;
+        if (pos < leftSize) {
+            erased = eraseFromChunk(node->left.get(), pos, count, removed);
+        } else if (pos >= chunkEnd) {
+            erased = eraseFromChunk(node->right.get(), pos - chunkEnd, count, removed);
+        } else if (pos + count <= chunkEnd && count < node->chunk.size()) {
+            if (removed) {
+                removed->assign(node->chunk, pos - leftSize, count);
+            }
+            node->chunk.erase(pos - leftSize, count);
+            erased = true;
+        } else {
+            erased = false;
+        }
+
+        if (erased) {
+            node->size -= count;
+        }
+        return erased;
+    }
+
+    static void append(const std::unique_ptr<Node>& node, std::string& out) {
+        if (!node) return;
+        append(node->left, out);
+        out += node->chunk;
+        append(node->right, out);
+    }
+
+public:
+    size_t size() const {
+        return sizeOf(root);
+    }
+
+    void insert(size_t pos, const std::string& text) {
+        if (text.empty()) return;
+        if (pos > size()) pos = size();
+        if (insertIntoChunk(root.get(), pos, text)) return;
+
+        auto [lower, upper] = split(std::move(root), pos);
+        std::unique_ptr<Node> middle;
+        for (size_t offset = 0; offset < text.size(); offset += MaxChunk) {
+            middle = merge(std::move(middle), std::make_unique<Node>(text.substr(offset, MaxChunk), nextPriority()));
+        }
+        root = merge(merge(std::move(lower), std::move(middle)), std::move(upper));
+    }
+
+    // Erase [pos, pos + count); the erased text is copied to *removed if given
+    void erase(size_t pos, size_t count, std::string* removed = nullptr) {
+        if (removed) removed->clear();
+        if (pos >= size() || count == 0) return;
+        count = std::min(count, size() - pos);
+        if (eraseFromChunk(root.get(), pos, count, removed)) return;
+
+        auto [lower, rest] = split(std::move(root), pos);
+        auto [middle, upper] = split(std::move(rest), count);
+        if (removed) {
+            append(middle, *removed);
+        }
+        root = merge(std::move(lower), std::move(upper));
+    }
+
+    std::string toString() const {
+        std::string out;
+        out.reserve(size());
+        append(root, out);
+        return out;
+    }
 };
 
-// Step 2: Create the Receiver (Text Editor)
+// Step 3: Create the Receiver (Text Editor)
+// Edits go straight to the rope; the flat string is only materialized when
+// getText() is called and is cached until the next edit. Echoing the whole
+// buffer after every edit is O(n) per keystroke, so it can be switched off.
 class TextEditor {
 private:
-    std::string text;
+    Rope text;
+    mutable std::string cachedText;
+    mutable bool cacheValid = true;
+    bool echo = true;
+    size_t edits = 0;
+
+    void changed() {
+        ++edits;
+        cacheValid = false;
+        if (echo) {
+            std::cout << "Current text: " << getText() << std::endl;
+        }
+    }
 
 public:
+    void setEcho(bool enabled) {
+        echo = enabled;
+    }
+
     void type(const std::string& newText) {
-        text += newText;
-        std::cout << "Current text: " << text << std::endl;
+        insert(text.size(), newText);
     }
 
     void erase(size_t count) {
         if (count > text.size()) {
             count = text.size();
         }
-        text.erase(text.size() - count, count);
-        std::cout << "Current text: " << text << std::endl;
+        eraseAt(text.size() - count, count);
+    }
+
+    // Erase the last count characters and hand them back (for undo)
+    std::string cut(size_t count) {
+        std::string removed;
+        count = std::min(count, text.size());
+        text.erase(text.size() - count, count, &removed);
+        changed();
+        return removed;
+    }
+
+    void insert(size_t pos, const std::string& newText) {
+        text.insert(pos, newText);
+        changed();
+    }
+
+    void eraseAt(size_t pos, size_t count) {
+        text.erase(pos, count);
+        changed();
+    }
+
+    size_t size() const {
+        return text.size();
+    }
+
+    // Number of edits applied so far (receiver calls that changed the text)
+    size_t editCount() const {
+        return edits;
     }
 
     std::string getText() const {
-        return text;
+        if (!cacheValid) {
+            cachedText = text.toString();
+            cacheValid = true;
+        }
+        return cachedText;
     }
 };
 
-// Step 3: Create concrete commands
+// Step 4: A memory-mapped journal of editor operations
+// Layout: a 64-byte header (magic, committed end offset, last checkpoint
+// offset) followed by records of [op:u8][length:u32][payload]. Commands are
+// journaled right after they run (a delete only knows what it removed once
+// it has run), so a crash can lose the last command but never replays one
+// that did not happen. A record only becomes visible to replay once the
+// header's end offset has moved past it, so a crash mid-append leaves a
+// consistent journal, and replay() stops at the first malformed record. checkpoint() stores the
+// full text, and replay() starts from the latest one instead of offset 0.
+// sync() forces the mapping to disk; without it the journal survives a
+// process crash but not a machine crash.
+class CommandJournal {
+private:
+    enum Op : uint8_t { TypeOp = 1, EraseOp = 2, SnapshotOp = 3 };
+
+    struct Header {
+        uint64_t magic;
+        uint64_t end;
+        uint64_t checkpoint;
+        uint64_t reserved[5];
+    };
+
+    static constexpr uint64_t Magic = 0x4c4e524a444d4f43ull;  // "COMDJRNL"
+    static constexpr size_t RecordHeaderSize = 1 + sizeof(uint32_t);
+
+    int fd = -1;
+    char* mapping = nullptr;
+    size_t mappedSize = 0;
+
+    Header* header() const {
+        return reinterpret_cast<Header*>(mapping);
+    }
+
+    static std::runtime_error systemError(const std::string& what) {
+        return std::runtime_error("CommandJournal: " + what + ": " + std::strerror(errno));
+    }
+
+    void reserve(size_t bytes) {
+        size_t needed = header()->end + bytes;
+        if (needed <= mappedSize) {
+            return;
+        }
+        size_t newSize = mappedSize;
+        while (newSize < needed) {
+            newSize *= 2;
+        }
+        if (ftruncate(fd, static_cast<off_t>(newSize)) != 0) {
+            throw systemError("ftruncate");
+        }
+        void* grown = mremap(mapping, mappedSize, newSize, MREMAP_MAYMOVE);
+        if (grown == MAP_FAILED) {
+            throw systemError("mremap");
+        }
+        mapping = static_cast<char*>(grown);
+        mappedSize = newSize;
+    }
+
+    uint64_t append(Op op, const void* payload, size_t length) {
+        if (length > UINT32_MAX) {
+            throw std::length_error("CommandJournal: record too large");
+        }
+        reserve(RecordHeaderSize + length);
+
+        uint64_t offset = header()->end;
+        char* record = mapping + offset;
+        uint32_t length32 = static_cast<uint32_t>(length);
+        record[0] = static_cast<char>(op);
+        std::memcpy(record + 1, &length32, sizeof(length32));
+        std::memcpy(record + RecordHeaderSize, payload, length);
+
+        // Publish the record only after its bytes are in place
+        std::atomic_thread_fence(std::memory_order_release);
+        header()->end = offset + RecordHeaderSize + length;
+        return offset;
+    }
+
+    // Check an existing file's header before anything is written to it
+    static void validate(int fd, size_t fileSize, const std::string& path) {
+        Header existing;
+        if (fileSize < sizeof(Header) ||
+            pread(fd, &existing, sizeof(existing), 0) != static_cast<ssize_t>(sizeof(existing)) ||
+            existing.magic != Magic) {
+            throw std::runtime_error("CommandJournal: " + path + " is not a command journal");
+        }
+        if (existing.end < sizeof(Header) || existing.end > fileSize ||
+            (existing.checkpoint != 0 &&
+             (existing.checkpoint < sizeof(Header) || existing.checkpoint >= existing.end))) {
+            throw std::runtime_error("CommandJournal: " + path + " has a corrupt header");
+        }
+    }
+
+    void mapFile(const std::string& path, size_t initialSize) {
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            throw systemError("fstat");
+        }
+        size_t fileSize = static_cast<size_t>(info.st_size);
+        if (fileSize > 0) {
+            validate(fd, fileSize, path);
+        }
+        mappedSize = std::max({fileSize, initialSize, sizeof(Header)});
+        if (fileSize < mappedSize && ftruncate(fd, static_cast<off_t>(mappedSize)) != 0) {
+            throw systemError("ftruncate");
+        }
+
+        void* mapped = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapped == MAP_FAILED) {
+            throw systemError("mmap");
+        }
+        mapping = static_cast<char*>(mapped);
+
+        if (fileSize == 0) {
+            std::memset(mapping, 0, sizeof(Header));
+            header()->magic = Magic;
+            header()->end = sizeof(Header);
+            header()->checkpoint = 0;
+        }
+    }
+
+    // The record at offset, if it is complete and well formed
+    bool readRecord(uint64_t offset, uint64_t end, Op& op, const char*& payload, uint32_t& length) const {
+        if (offset + RecordHeaderSize > end) {
+            return false;
+        }
+        const char* record = mapping + offset;
+        std::memcpy(&length, record + 1, sizeof(length));
+        if (length > end - offset - RecordHeaderSize) {
+            return false;
+        }
+        op = static_cast<Op>(record[0]);
+        payload = record + RecordHeaderSize;
+        switch (op) {
+        case TypeOp:
+        case SnapshotOp:
+            return true;
+        case EraseOp:
+            return length == sizeof(uint64_t);
+        }
+        return false;
+    }
+
+public:
+    // Opens the journal at path, creating it if the file is missing or
+    // empty. Throws if the file exists but is not a valid journal, rather
+    // than overwriting it.
+    explicit CommandJournal(const std::string& path, size_t initialSize = 1 << 20) {
+        fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd < 0) {
+            throw systemError("open " + path);
+        }
+        try {
+            mapFile(path, initialSize);
+        } catch (...) {
+            close(fd);
+            throw;
+        }
+    }
+
+    ~CommandJournal() {
+        if (mapping) {
+            munmap(mapping, mappedSize);
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    CommandJournal(const CommandJournal&) = delete;
+    CommandJournal& operator=(const CommandJournal&) = delete;
+
+    void appendType(const std::string& text) {
+        append(TypeOp, text.data(), text.size());
+    }
+
+    void appendErase(uint64_t count) {
+        append(EraseOp, &count, sizeof(count));
+    }
+
+    // Snapshot the editor so replay can skip everything before this point
+    void checkpoint(const TextEditor& editor) {
+        std::string text = editor.getText();
+        header()->checkpoint = append(SnapshotOp, text.data(), text.size());
+    }
+
+    void sync() const {
+        if (msync(mapping, header()->end, MS_SYNC) != 0) {
+            throw systemError("msync");
+        }
+    }
+
+    size_t bytesUsed() const {
+        return header()->end;
+    }
+
+    // Rebuild editor state from the latest checkpoint (or the start) onwards.
+    // Runs of typed text are concatenated and applied as one insert.
+    // Returns the number of records replayed.
+    size_t replay(TextEditor& editor) const {
+        uint64_t end = std::min<uint64_t>(header()->end, mappedSize);
+        uint64_t offset = sizeof(Header);
+        Op op;
+        const char* payload;
+        uint32_t length;
+        uint64_t checkpoint = header()->checkpoint;
+        if (checkpoint >= sizeof(Header) && readRecord(checkpoint, end, op, payload, length) && op == SnapshotOp) {
+            offset = checkpoint;
+        }
+        std::string typed;
+        size_t records = 0;
+
+        while (readRecord(offset, end, op, payload, length)) {
+            switch (op) {
+            case SnapshotOp:
+                typed.clear();
+                editor.erase(editor.size());
+                editor.type(std::string(payload, length));
+                break;
+            case TypeOp:
+                typed.append(payload, length);
+                break;
+            case EraseOp: {
+                uint64_t count;
+                std::memcpy(&count, payload, sizeof(count));
+                size_t fromTyped = static_cast<size_t>(std::min<uint64_t>(count, typed.size()));
+                typed.resize(typed.size() - fromTyped);
+                if (count > fromTyped) {
+                    if (!typed.empty()) {
+                        editor.type(typed);
+                        typed.clear();
+                    }
+                    editor.erase(static_cast<size_t>(count - fromTyped));
+                }
+                break;
+            }
+            }
+
+            offset += RecordHeaderSize + length;
+            ++records;
+        }
+
+        if (!typed.empty()) {
+            editor.type(typed);
+        }
+        return records;
+    }
+};
+
+// Step 5: Create concrete commands
 class TypeCommand : public Command {
 private:
     TextEditor& editor;
@@ -51,42 +558,124 @@ public:
     void undo() override {
         editor.erase(textToType.size());
     }
+
+    bool mergeWith(const Command& next) override {
+        auto* typed = dynamic_cast<const TypeCommand*>(&next);
+        if (!typed || &typed->editor != &editor) {
+            return false;
+        }
+        textToType += typed->textToType;
+        return true;
+    }
+
+    void record(CommandJournal& journal) const override {
+        journal.appendType(textToType);
+    }
+
+    void recordUndo(CommandJournal& journal) const override {
+        journal.appendErase(textToType.size());
+    }
 };
 
 class DeleteCommand : public Command {
 private:
     TextEditor& editor;
     size_t count;
+    std::string deletedText;  // Captured on execute so undo can put it back
 
 public:
     DeleteCommand(TextEditor& editor, size_t count)
         : editor(editor), count(count) {}
 
     void execute() override {
-        editor.erase(count);
+        deletedText = editor.cut(count);
     }
 
     void undo() override {
-        // Undoing delete is a bit tricky without storing state, 
-        // so we assume we cannot undo deletes without additional logic.
-        std::cout << "Cannot undo delete in this simple example." << std::endl;
+        editor.type(deletedText);
+    }
+
+    bool mergeWith(const Command& next) override {
+        auto* deletion = dynamic_cast<const DeleteCommand*>(&next);
+        if (!deletion || &deletion->editor != &editor) {
+            return false;
+        }
+        count += deletion->count;
+        deletedText = deletion->deletedText + deletedText;  // It cut the text just before ours
+        return true;
+    }
+
+    void record(CommandJournal& journal) const override {
+        journal.appendErase(deletedText.size());
+    }
+
+    void recordUndo(CommandJournal& journal) const override {
+        journal.appendType(deletedText);
     }
 };
 
-// Step 4: Create the Invoker to execute and store commands
+// Step 6: Create the Invoker to execute and store commands
+// Every command runs against the editor as soon as it arrives. With a group
+// window, compatible commands arriving back to back (within maxGroupSize
+// commands and groupWindow of each other) are folded into one history
+// entry, so undo reverts the whole group as one step. An incompatible
+// command, undo, or flush() closes the group.
 class CommandInvoker {
 private:
     std::stack<std::unique_ptr<Command>> commandHistory;
+    bool groupOpen = false;  // The top entry may still absorb commands
+    size_t groupSize = 0;
+    std::chrono::steady_clock::time_point lastExecuted;
+    size_t maxGroupSize = 1;
+    std::chrono::steady_clock::duration groupWindow = std::chrono::steady_clock::duration::zero();
+    CommandJournal* journal = nullptr;
 
 public:
+    CommandInvoker() = default;
+
+    CommandInvoker(size_t maxGroupSize, std::chrono::steady_clock::duration groupWindow)
+        : maxGroupSize(maxGroupSize), groupWindow(groupWindow) {}
+
+    // Log every executed and undone command to the journal
+    void attachJournal(CommandJournal* commandJournal) {
+        journal = commandJournal;
+    }
+
     void executeCommand(std::unique_ptr<Command> command) {
         command->execute();
+        if (journal) {
+            command->record(*journal);
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (groupOpen && groupSize < maxGroupSize && now - lastExecuted <= groupWindow &&
+            commandHistory.top()->mergeWith(*command)) {
+            ++groupSize;
+            lastExecuted = now;
+            return;
+        }
         commandHistory.push(std::move(command));
+        groupOpen = true;
+        groupSize = 1;
+        lastExecuted = now;
+    }
+
+    // Close the current group: the next command starts a new undo step
+    void flush() {
+        groupOpen = false;
+    }
+
+    size_t historySize() const {
+        return commandHistory.size();
     }
 
     void undoLastCommand() {
+        flush();
         if (!commandHistory.empty()) {
             commandHistory.top()->undo();
+            if (journal) {
+                commandHistory.top()->recordUndo(*journal);
+            }
             commandHistory.pop();
         } else {
             std::cout << "No commands to undo!" << std::endl;
@@ -94,8 +683,394 @@ public:
     }
 };
 
-// Step 5: Use the Command pattern in client code
-int main() {
+// Step 7: An allocation-free history with redo
+// InlineCommand stores any command object inside a fixed in-place buffer and
+// dispatches through a per-type function table, so keeping a command costs no
+// heap allocation beyond what the command's own members need (a TypeCommand
+// whose text outgrows std::string's inline buffer still allocates for it).
+// CommandHistory keeps those slots in a ring allocated once up front: the
+// oldest entries are overwritten once the depth cap is reached, and undone
+// entries stay in the ring until a new command replaces them.
+class InlineCommand {
+private:
+    static constexpr size_t Capacity = 64;
+
+    struct Ops {
+        void (*execute)(void*);
+        void (*undo)(void*);
+        void (*destroy)(void*);
+    };
+
+    template <typename C>
+    static const Ops* opsFor() {
+        static const Ops ops = {
+            [](void* command) { static_cast<C*>(command)->C::execute(); },
+            [](void* command) { static_cast<C*>(command)->C::undo(); },
+            [](void* command) { static_cast<C*>(command)->~C(); }};
+        return &ops;
+    }
+
+    alignas(std::max_align_t) unsigned char storage[Capacity];
+    const Ops* ops = nullptr;
+
+public:
+    InlineCommand() = default;
+    InlineCommand(const InlineCommand&) = delete;
+    InlineCommand& operator=(const InlineCommand&) = delete;
+
+    ~InlineCommand() {
+        reset();
+    }
+
+    template <typename C, typename... Args>
+    C& emplace(Args&&... args) {
+        static_assert(sizeof(C) <= Capacity, "Command too large for InlineCommand");
+        static_assert(alignof(C) <= alignof(std::max_align_t), "Command over-aligned for InlineCommand");
+        reset();
+        C* command = new (storage) C(std::forward<Args>(args)...);
+        ops = opsFor<C>();
+        return *command;
+    }
+
+    void reset() {
+        if (ops) {
+            ops->destroy(storage);
+            ops = nullptr;
+        }
+    }
+
+    void execute() {
+        ops->execute(storage);
+    }
+
+    void undo() {
+        ops->undo(storage);
+    }
+};
+
+class CommandHistory {
+private:
+    std::unique_ptr<InlineCommand[]> ring;
+    size_t depth;
+    size_t oldest = 0;     // Ring index of the oldest undoable command
+    size_t undoable = 0;   // Commands that can be undone
+    size_t redoable = 0;   // Undone commands that can be redone
+
+    size_t slot(size_t offset) const {
+        return (oldest + offset) % depth;
+    }
+
+public:
+    explicit CommandHistory(size_t depth = 1024)
+        : ring(std::make_unique<InlineCommand[]>(depth == 0 ? 1 : depth)), depth(depth == 0 ? 1 : depth) {}
+
+    // Build the command directly inside its history slot and run it
+    template <typename C, typename... Args>
+    void executeCommand(Args&&... args) {
+        for (size_t i = 0; i < redoable; ++i) {
+            ring[slot(undoable + i)].reset();
+        }
+        redoable = 0;
+
+        if (undoable == depth) {
+            oldest = slot(1);
+            --undoable;
+        }
+
+        InlineCommand& command = ring[slot(undoable)];
+        command.emplace<C>(std::forward<Args>(args)...);
+        command.execute();
+        ++undoable;
+    }
+
+    void undoLastCommand() {
+        if (undoable == 0) {
+            std::cout << "No commands to undo!" << std::endl;
+            return;
+        }
+        --undoable;
+        ++redoable;
+        ring[slot(undoable)].undo();
+    }
+
+    void redoLastCommand() {
+        if (redoable == 0) {
+            std::cout << "No commands to redo!" << std::endl;
+            return;
+        }
+        ring[slot(undoable)].execute();
+        ++undoable;
+        --redoable;
+    }
+
+    size_t undoDepth() const {
+        return undoable;
+    }
+
+    size_t redoDepth() const {
+        return redoable;
+    }
+};
+
+// Step 8: Benchmarks
+// 8a: Replay a 1M-keystroke editing trace
+// The trace types at a cursor, backspaces now and then and occasionally jumps
+// to a random position in a multi-megabyte document. A flat std::string
+// replays only a prefix of it, because every mid-document edit is a memmove
+// of the whole tail.
+struct Keystroke {
+    enum Kind { Type, Backspace, Jump } kind;
+    size_t position;
+};
+
+std::vector<Keystroke> makeEditingTrace(size_t count, size_t documentSize) {
+    std::vector<Keystroke> trace;
+    trace.reserve(count);
+    uint64_t seed = 88172645463325252ull;
+    for (size_t i = 0; i < count; ++i) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        unsigned roll = static_cast<unsigned>(seed % 100);
+        if (roll < 85) {
+            trace.push_back({Keystroke::Type, 0});
+        } else if (roll < 97) {
+            trace.push_back({Keystroke::Backspace, 0});
+        } else {
+            trace.push_back({Keystroke::Jump, static_cast<size_t>(seed >> 8) % documentSize});
+        }
+    }
+    return trace;
+}
+
+template <typename InsertFn, typename EraseFn, typename SizeFn>
+double replayTrace(const std::vector<Keystroke>& trace, size_t keystrokes,
+                   InsertFn insert, EraseFn erase, SizeFn size) {
+    const std::string key = "x";
+    size_t cursor = size() / 2;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < keystrokes; ++i) {
+        const Keystroke& stroke = trace[i];
+        if (stroke.kind == Keystroke::Type) {
+            insert(cursor, key);
+            ++cursor;
+        } else if (stroke.kind == Keystroke::Backspace) {
+            if (cursor > 0) {
+                erase(--cursor, 1);
+            }
+        } else {
+            cursor = std::min(stroke.position, size());
+        }
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void benchmarkEditingTrace() {
+    const size_t documentSize = 4 << 20;
+    const size_t keystrokes = 1000000;
+    const size_t flatKeystrokes = 20000;
+    auto trace = makeEditingTrace(keystrokes, documentSize);
+    std::string document(documentSize, 'a');
+
+    TextEditor editor;
+    editor.setEcho(false);
+    editor.type(document);
+    double ropeSeconds = replayTrace(trace, keystrokes,
+        [&](size_t pos, const std::string& key) { editor.insert(pos, key); },
+        [&](size_t pos, size_t count) { editor.eraseAt(pos, count); },
+        [&]() { return editor.size(); });
+
+    auto start = std::chrono::steady_clock::now();
+    size_t finalSize = editor.getText().size();
+    double materializeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::string flat = document;
+    double flatSeconds = replayTrace(trace, flatKeystrokes,
+        [&](size_t pos, const std::string& key) { flat.insert(pos, key); },
+        [&](size_t pos, size_t count) { flat.erase(pos, count); },
+        [&]() { return flat.size(); });
+
+    std::cout << "Rope: " << keystrokes << " keystrokes on a " << (documentSize >> 20) << " MB document in "
+              << ropeSeconds << " s (" << ropeSeconds * 1e9 / keystrokes << " ns/keystroke)" << std::endl;
+    std::cout << "Rope: getText() of " << finalSize << " bytes in " << materializeSeconds * 1e3 << " ms" << std::endl;
+    std::cout << "std::string: first " << flatKeystrokes << " keystrokes in " << flatSeconds << " s ("
+              << flatSeconds * 1e9 / flatKeystrokes << " ns/keystroke)" << std::endl;
+}
+
+// 8b: Typing-heavy workload with and without undo coalescing
+void benchmarkCoalescing() {
+    const size_t keystrokes = 1000000;
+    const std::string keys = "the quick brown fox ";
+
+    auto run = [&](CommandInvoker& invoker, TextEditor& editor) {
+        editor.setEcho(false);
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < keystrokes; ++i) {
+            if (i % 50 == 49) {
+                invoker.executeCommand(std::make_unique<DeleteCommand>(editor, 1));
+            } else {
+                invoker.executeCommand(std::make_unique<TypeCommand>(editor, std::string(1, keys[i % keys.size()])));
+            }
+        }
+        invoker.flush();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    TextEditor plainEditor, groupedEditor;
+    CommandInvoker plain;
+    CommandInvoker grouped(32, std::chrono::milliseconds(500));
+    double plainSeconds = run(plain, plainEditor);
+    double groupedSeconds = run(grouped, groupedEditor);
+
+    std::cout << "Ungrouped: " << plain.historySize() << " history entries, " << plainSeconds * 1e9 / keystrokes
+              << " ns/keystroke" << std::endl;
+    std::cout << "Grouped:   " << grouped.historySize() << " history entries, "
+              << groupedSeconds * 1e9 / keystrokes << " ns/keystroke" << std::endl;
+    if (plainEditor.getText() != groupedEditor.getText()) {
+        std::cout << "Mismatch between grouped and ungrouped text!" << std::endl;
+    }
+
+    // Undoing every group must walk the text back to empty
+    auto start = std::chrono::steady_clock::now();
+    size_t groups = grouped.historySize();
+    while (grouped.historySize() > 0) {
+        grouped.undoLastCommand();
+    }
+    double undoSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Grouped undo: " << groups << " steps in " << undoSeconds * 1e3 << " ms"
+              << (groupedEditor.size() == 0 ? "" : ", text not restored!") << std::endl;
+}
+
+// 8c: Count heap allocations on the execute/undo/redo paths
+// Counted by allocation_counter.h. "x" fits std::string's inline buffer (15
+// characters in libstdc++); the words run past it, so each TypeCommand then
+// allocates for its own text, even inside a CommandHistory slot.
+void benchmarkCommandAllocations() {
+    const size_t keystrokes = 1000000;
+    const std::vector<std::string> words = {"x", "refactoring ", "the configuration loader ",
+                                            "std::unordered_map<std::string, int> "};
+    TextEditor editor;
+    editor.setEcho(false);
+    editor.type("Warm-up text so the rope already has a chunk to grow.");
+
+    for (const std::string& word : words) {
+        CommandInvoker invoker;
+        size_t before = allocationCount;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < keystrokes; ++i) {
+            invoker.executeCommand(std::make_unique<TypeCommand>(editor, word));
+            invoker.undoLastCommand();
+        }
+        double invokerSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        size_t invokerAllocations = allocationCount - before;
+
+        CommandHistory history(256);
+        for (size_t i = 0; i < 512; ++i) {  // Fill the ring once so every slot has been used
+            history.executeCommand<TypeCommand>(editor, word);
+        }
+        before = allocationCount;
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < keystrokes; ++i) {
+            history.executeCommand<TypeCommand>(editor, word);
+            history.undoLastCommand();
+            history.redoLastCommand();
+            history.undoLastCommand();
+        }
+        double historySeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        size_t historyAllocations = allocationCount - before;
+
+        std::cout << "Typing \"" << word << "\" (" << word.size() << " chars):" << std::endl;
+        std::cout << "  CommandInvoker: " << double(invokerAllocations) / keystrokes
+                  << " allocations per execute+undo (" << invokerSeconds * 1e9 / keystrokes << " ns)" << std::endl;
+        std::cout << "  CommandHistory: " << double(historyAllocations) / keystrokes
+                  << " allocations per execute+undo+redo+undo (" << historySeconds * 1e9 / keystrokes << " ns)"
+                  << std::endl;
+    }
+}
+
+// Creates a new, empty, owner-only file in the temp directory and returns its
+// path. mkstemp() picks a name nobody else holds, so a planted file or
+// symlink at a predictable path cannot be opened in its place.
+std::string makeTempFile(const std::string& prefix) {
+    std::string path = (std::filesystem::temp_directory_path() / (prefix + ".XXXXXX")).string();
+    int fd = mkstemp(path.data());
+    if (fd < 0) {
+        throw std::runtime_error("mkstemp " + path + ": " + std::strerror(errno));
+    }
+    close(fd);
+    return path;
+}
+
+// 8d: Journal append overhead and replay throughput
+void benchmarkJournal() {
+    const size_t commands = 1000000;
+    std::string path = makeTempFile("command_journal_bench");
+
+    auto typeAll = [&](CommandInvoker& invoker, TextEditor& editor) {
+        editor.setEcho(false);
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < commands; ++i) {
+            if (i % 10 == 9) {
+                invoker.executeCommand(std::make_unique<DeleteCommand>(editor, 1));
+            } else {
+                invoker.executeCommand(std::make_unique<TypeCommand>(editor, "k"));
+            }
+        }
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    TextEditor plainEditor, journaledEditor;
+    CommandInvoker plain, journaled;
+    double plainSeconds = typeAll(plain, plainEditor);
+
+    size_t journalBytes;
+    double journaledSeconds;
+    {
+        CommandJournal journal(path);
+        journaled.attachJournal(&journal);
+        journaledSeconds = typeAll(journaled, journaledEditor);
+        journaled.attachJournal(nullptr);
+        journalBytes = journal.bytesUsed();
+    }
+
+    CommandJournal journal(path);
+    TextEditor recovered;
+    recovered.setEcho(false);
+    auto start = std::chrono::steady_clock::now();
+    size_t records = journal.replay(recovered);
+    double replaySeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    journal.checkpoint(recovered);
+    TextEditor fromCheckpoint;
+    fromCheckpoint.setEcho(false);
+    start = std::chrono::steady_clock::now();
+    size_t checkpointRecords = journal.replay(fromCheckpoint);
+    double checkpointSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Journal append overhead: "
+              << (journaledSeconds - plainSeconds) * 1e9 / commands << " ns/command ("
+              << static_cast<double>(journalBytes) / commands << " bytes/command)" << std::endl;
+    std::cout << "Replay: " << records << " records in " << replaySeconds * 1e3 << " ms ("
+              << records / replaySeconds / 1e6 << " M commands/s)" << std::endl;
+    std::cout << "Replay from checkpoint: " << checkpointRecords << " record(s) in "
+              << checkpointSeconds * 1e3 << " ms" << std::endl;
+    if (recovered.getText() != journaledEditor.getText() || fromCheckpoint.getText() != journaledEditor.getText()) {
+        std::cout << "Replayed text does not match the original!" << std::endl;
+    }
+    std::remove(path.c_str());
+}
+
+// Step 9: Use the Command pattern in client code
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        benchmarkEditingTrace();
+        benchmarkCoalescing();
+        benchmarkCommandAllocations();
+        benchmarkJournal();
+        return 0;
+    }
+
     TextEditor editor;
     CommandInvoker invoker;
 
@@ -112,5 +1087,46 @@ int main() {
     // User deletes the last 5 characters ("there")
     invoker.executeCommand(std::make_unique<DeleteCommand>(editor, 5));
 
+    // The same editing session through the allocation-free history, with redo
+    TextEditor draft;
+    CommandHistory history(16);
+    history.executeCommand<TypeCommand>(draft, "Hello, ");
+    history.executeCommand<TypeCommand>(draft, "World!");
+    history.undoLastCommand(); // Output: Current text: Hello,
+    history.redoLastCommand(); // Output: Current text: Hello, World!
+
+    // Fast typing: keystrokes inside the window merge into one undo step
+    TextEditor notes;
+    CommandInvoker typist(64, std::chrono::milliseconds(300));
+    for (char key : std::string("Quick note")) {
+        typist.executeCommand(std::make_unique<TypeCommand>(notes, std::string(1, key)));
+    }                            // Output: Current text: Q ... Quick note (one line per keystroke)
+    typist.executeCommand(std::make_unique<DeleteCommand>(notes, 5));  // Output: Current text: Quick
+    typist.undoLastCommand();    // Output: Current text: Quick note
+    typist.undoLastCommand();    // Output: Current text: (the whole typed group is undone)
+
+    // Journal a session, then rebuild it as if after a crash
+    std::string journalPath = makeTempFile("command_journal_demo");
+    {
+        TextEditor session;
+        CommandJournal journal(journalPath);
+        CommandInvoker journaled;
+        journaled.attachJournal(&journal);
+        journaled.executeCommand(std::make_unique<TypeCommand>(session, "Saved "));
+        journal.checkpoint(session);
+        journaled.executeCommand(std::make_unique<TypeCommand>(session, "and journaled"));
+        journaled.executeCommand(std::make_unique<DeleteCommand>(session, 9));
+        journaled.undoLastCommand();
+        journal.sync();
+    }
+    {
+        TextEditor recovered;
+        recovered.setEcho(false);
+        CommandJournal journal(journalPath);
+        size_t records = journal.replay(recovered);
+        std::cout << "Recovered from " << records << " journal records: " << recovered.getText() << std::endl;
+    }
+    std::remove(journalPath.c_str());
+
     return 0;
 }
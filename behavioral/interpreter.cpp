@@ -1,17 +1,71 @@
-
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
 #include <iostream>
 #include <memory>
+#include <new>
+#include <span>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <unordered_map>
 #include <vector>
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define INTERPRETER_HAVE_AVX2 1
+#endif
+
+#if defined(__x86_64__) && defined(__linux__)
+#include <sys/mman.h>
+#define INTERPRETER_HAVE_JIT 1
+#endif
+
+class Number;
+class Variable;
+class Add;
+class Subtract;
+class Multiply;
+
 // Step 1: Define the Abstract Expression class
+// accept() lets tools outside the class hierarchy (such as the bytecode
+// compiler below) walk the tree without adding a virtual per tool.
+class ExpressionVisitor {
+public:
+    virtual ~ExpressionVisitor() = default;
+    virtual void visit(const Number& number) = 0;
+    virtual void visit(const Variable& variable) = 0;
+    virtual void visit(const Add& add) = 0;
+    virtual void visit(const Subtract& subtract) = 0;
+    virtual void visit(const Multiply& multiply) = 0;
+};
+
 class Expression {
 public:
     virtual ~Expression() = default;
     virtual int interpret() const = 0;
+    virtual void accept(ExpressionVisitor& visitor) const = 0;
 };
 
+// Every evaluator in this file does int arithmetic modulo 2^32, the way the
+// hardware does, so overflow is defined and all paths agree on the result
+inline int wrappingAdd(int left, int right) {
+    return static_cast<int>(static_cast<uint32_t>(left) + static_cast<uint32_t>(right));
+}
+
+inline int wrappingSubtract(int left, int right) {
+    return static_cast<int>(static_cast<uint32_t>(left) - static_cast<uint32_t>(right));
+}
+
+inline int wrappingMultiply(int left, int right) {
+    return static_cast<int>(static_cast<uint32_t>(left) * static_cast<uint32_t>(right));
+}
+
 // Step 2: Create concrete classes for Number and Operations
 class Number : public Expression {
 private:
@@ -23,6 +77,41 @@ public:
     int interpret() const override {
         return value;
     }
+
+    void accept(ExpressionVisitor& visitor) const override {
+        visitor.visit(*this);
+    }
+
+    int getValue() const {
+        return value;
+    }
+};
+
+// A named input. interpret() reads the value last given to setValue(); the
+// compiled evaluators below take variable values as arguments instead.
+class Variable : public Expression {
+private:
+    std::string name;
+    int value;
+
+public:
+    explicit Variable(std::string name, int value = 0) : name(std::move(name)), value(value) {}
+
+    int interpret() const override {
+        return value;
+    }
+
+    void accept(ExpressionVisitor& visitor) const override {
+        visitor.visit(*this);
+    }
+
+    const std::string& getName() const {
+        return name;
+    }
+
+    void setValue(int newValue) {
+        value = newValue;
+    }
 };
 
 class Add : public Expression {
@@ -34,8 +123,15 @@ public:
         : left(left), right(right) {}
 
     int interpret() const override {
-        return left->interpret() + right->interpret();
+        return wrappingAdd(left->interpret(), right->interpret());
     }
+
+    void accept(ExpressionVisitor& visitor) const override {
+        visitor.visit(*this);
+    }
+
+    const std::shared_ptr<Expression>& getLeft() const { return left; }
+    const std::shared_ptr<Expression>& getRight() const { return right; }
 };
 
 class Subtract : public Expression {
@@ -47,8 +143,15 @@ public:
         : left(left), right(right) {}
 
     int interpret() const override {
-        return left->interpret() - right->interpret();
+        return wrappingSubtract(left->interpret(), right->interpret());
+    }
+
+    void accept(ExpressionVisitor& visitor) const override {
+        visitor.visit(*this);
     }
+
+    const std::shared_ptr<Expression>& getLeft() const { return left; }
+    const std::shared_ptr<Expression>& getRight() const { return right; }
 };
 
 // Step 3: Extend with more operations (e.g., Multiplication)
@@ -61,12 +164,1430 @@ public:
         : left(left), right(right) {}
 
     int interpret() const override {
-        return left->interpret() * right->interpret();
+        return wrappingMultiply(left->interpret(), right->interpret());
     }
+
+    void accept(ExpressionVisitor& visitor) const override {
+        visitor.visit(*this);
+    }
+
+    const std::shared_ptr<Expression>& getLeft() const { return left; }
+    const std::shared_ptr<Expression>& getRight() const { return right; }
+};
+
+// Step 4: Compile an Expression tree into flat bytecode
+// The program is a contiguous list of three-address instructions over a
+// register file. Constants are loaded into the first registers, variable
+// values (passed to run() in getVariables() order) into the next ones, and every
+// operation writes its own register (static single assignment), so there is
+// no stack to manage and no allocation at run time beyond the register file.
+// The operation is selected arithmetically rather than with a switch, which
+// keeps the loop free of unpredictable branches on mixed-operator programs.
+enum class OpCode : uint8_t { Add, Subtract, Multiply };
+
+struct Instruction {
+    OpCode op;
+    uint32_t left;   // Register indices
+    uint32_t right;
 };
 
-// Step 4: Client code to interpret expressions
-int main() {
+class BytecodeProgram {
+private:
+    std::vector<int> constants;          // Initial contents of registers [0, constants.size())
+    std::vector<std::string> variables;  // Loaded into the registers after the constants
+    std::vector<Instruction> code;       // Instruction i writes the register after those
+    uint32_t result = 0;                 // Register holding the final value
+
+    friend class BytecodeCompiler;
+    friend class ExpressionDag;
+
+public:
+    int run(std::span<const int> variableValues = {}) const {
+        std::vector<int> registers(registerCount());
+        return run(variableValues, registers.data());
+    }
+
+    // Run with caller-provided scratch of at least registerCount() ints
+    int run(std::span<const int> variableValues, int* registers) const {
+        if (variableValues.size() != variables.size()) {
+            throw std::invalid_argument("BytecodeProgram: expected " + std::to_string(variables.size()) +
+                                        " variable values");
+        }
+        std::copy(constants.begin(), constants.end(), registers);
+        std::copy(variableValues.begin(), variableValues.end(), registers + constants.size());
+        int* out = registers + constants.size() + variables.size();
+        for (const Instruction& instruction : code) {
+            // All three results are computed; wrapping keeps the ones not
+            // chosen defined too
+            int left = registers[instruction.left];
+            int right = registers[instruction.right];
+            int sum = wrappingAdd(left, right);
+            int difference = wrappingSubtract(left, right);
+            int product = wrappingMultiply(left, right);
+            *out++ = instruction.op == OpCode::Add ? sum
+                   : instruction.op == OpCode::Subtract ? difference
+                   : product;
+        }
+        return registers[result];
+    }
+
+    size_t registerCount() const {
+        return constants.size() + variables.size() + code.size();
+    }
+
+    const std::vector<std::string>& getVariables() const {
+        return variables;
+    }
+
+    size_t size() const {
+        return code.size();
+    }
+};
+
+class BytecodeCompiler : public ExpressionVisitor {
+private:
+    // Constants are numbered as they appear, and variables and temporaries
+    // from zero with these bits set; compile() moves them past the constant
+    // block once its final size is known.
+    static constexpr uint32_t TempBit = 0x80000000u;
+    static constexpr uint32_t VariableBit = 0x40000000u;
+
+    BytecodeProgram program;
+    std::unordered_map<int, uint32_t> constantRegisters;  // Each distinct constant is loaded once
+    std::unordered_map<std::string, uint32_t> variableRegisters;
+    std::vector<uint32_t> operands;                       // Registers of already-compiled subtrees
+
+    void binary(const Expression& left, const Expression& right, OpCode op) {
+        left.accept(*this);
+        right.accept(*this);
+        uint32_t rightRegister = operands.back();
+        operands.pop_back();
+        uint32_t leftRegister = operands.back();
+        operands.pop_back();
+
+        program.code.push_back({op, leftRegister, rightRegister});
+        operands.push_back(TempBit | static_cast<uint32_t>(program.code.size() - 1));
+    }
+
+public:
+    static BytecodeProgram compile(const Expression& expression) {
+        BytecodeCompiler compiler;
+        expression.accept(compiler);
+
+        BytecodeProgram& program = compiler.program;
+        uint32_t variableBase = static_cast<uint32_t>(program.constants.size());
+        uint32_t tempBase = variableBase + static_cast<uint32_t>(program.variables.size());
+        auto relocate = [=](uint32_t reg) {
+            if (reg & TempBit) return (reg & ~TempBit) + tempBase;
+            if (reg & VariableBit) return (reg & ~VariableBit) + variableBase;
+            return reg;
+        };
+        for (Instruction& instruction : program.code) {
+            instruction.left = relocate(instruction.left);
+            instruction.right = relocate(instruction.right);
+        }
+        program.result = relocate(compiler.operands.back());
+        return std::move(program);
+    }
+
+    void visit(const Number& number) override {
+        auto [entry, inserted] = constantRegisters.try_emplace(
+            number.getValue(), static_cast<uint32_t>(program.constants.size()));
+        if (inserted) {
+            program.constants.push_back(number.getValue());
+        }
+        operands.push_back(entry->second);
+    }
+
+    void visit(const Variable& variable) override {
+        auto [entry, inserted] = variableRegisters.try_emplace(
+            variable.getName(), VariableBit | static_cast<uint32_t>(program.variables.size()));
+        if (inserted) {
+            program.variables.push_back(variable.getName());
+        }
+        operands.push_back(entry->second);
+    }
+
+    void visit(const Add& add) override {
+        binary(*add.getLeft(), *add.getRight(), OpCode::Add);
+    }
+
+    void visit(const Subtract& subtract) override {
+        binary(*subtract.getLeft(), *subtract.getRight(), OpCode::Subtract);
+    }
+
+    void visit(const Multiply& multiply) override {
+        binary(*multiply.getLeft(), *multiply.getRight(), OpCode::Multiply);
+    }
+};
+
+// Step 5: Parse text into Expression trees allocated from a bump arena
+// Nodes are placement-constructed in large blocks, so building a node is a
+// pointer bump. make() hands back an ArenaRef, a plain non-owning handle that
+// cannot be mistaken for a shared_ptr; it is valid until the arena is reset
+// or destroyed. Children given as ArenaRefs are linked through non-owning
+// shared_ptrs (aliasing constructor, no control block), so linking touches no
+// refcount; those links must not be copied out of the tree and kept past the
+// arena either. Blocks double in size (64 KB up to 16 MB), so even a huge
+// parse owns only a handful of them. Only nodes that own something (a
+// Variable's name, a shared_ptr child passed to make()) go on the destroy
+// list; Numbers and operations linked purely through ArenaRefs own nothing,
+// so reset() releases them by rewinding the cursor without touching them.
+template <typename T>
+class ArenaRef {
+private:
+    T* node = nullptr;
+
+public:
+    ArenaRef() = default;
+    explicit ArenaRef(T* node) : node(node) {}
+
+    template <typename U>
+        requires std::is_convertible_v<U*, T*>
+    ArenaRef(ArenaRef<U> other) : node(other.get()) {}
+
+    T* get() const { return node; }
+    T& operator*() const { return *node; }
+    T* operator->() const { return node; }
+    explicit operator bool() const { return node != nullptr; }
+};
+
+// A shared_ptr handed to make() may own its child; ArenaRefs never do
+template <typename Arg>
+constexpr bool isOwningChild = false;
+
+template <typename U>
+constexpr bool isOwningChild<std::shared_ptr<U>> = true;
+
+class ExpressionArena {
+private:
+    static constexpr size_t FirstBlockSize = 64 * 1024;
+    static constexpr size_t MaxBlockSize = 16 * 1024 * 1024;
+
+    std::vector<std::unique_ptr<std::byte[]>> blocks;
+    size_t blockSize = 0;
+    size_t nextBlockSize = FirstBlockSize;
+    std::byte* cursor = nullptr;
+    size_t remaining = 0;
+    std::vector<Expression*> owners;  // Nodes with owned state, destroyed in reverse
+    size_t nodes = 0;
+
+    void* allocate(size_t size, size_t alignment) {
+        size_t padding = (alignment - reinterpret_cast<uintptr_t>(cursor) % alignment) % alignment;
+        if (!cursor || padding + size > remaining) {
+            blocks.push_back(std::make_unique_for_overwrite<std::byte[]>(nextBlockSize));
+            cursor = blocks.back().get();
+            remaining = blockSize = nextBlockSize;
+            nextBlockSize = std::min(nextBlockSize * 2, MaxBlockSize);
+            padding = 0;
+        }
+        void* memory = cursor + padding;
+        cursor += padding + size;
+        remaining -= padding + size;
+        return memory;
+    }
+
+    template <typename T>
+    static std::shared_ptr<Expression> link(ArenaRef<T> child) {
+        return std::shared_ptr<Expression>(std::shared_ptr<Expression>(), child.get());
+    }
+
+    template <typename Arg>
+    static Arg&& link(Arg&& arg) {
+        return std::forward<Arg>(arg);
+    }
+
+    // Unknown node types are destroyed conservatively
+    template <typename T, typename... Args>
+    static constexpr bool ownsState =
+        !(std::is_same_v<T, Number> || std::is_same_v<T, Add> || std::is_same_v<T, Subtract> ||
+          std::is_same_v<T, Multiply>) ||
+        (isOwningChild<std::remove_cvref_t<Args>> || ...);
+
+public:
+    ExpressionArena() = default;
+    ExpressionArena(const ExpressionArena&) = delete;
+    ExpressionArena& operator=(const ExpressionArena&) = delete;
+
+    ~ExpressionArena() {
+        reset();
+    }
+
+    template <typename T, typename... Args>
+    ArenaRef<T> make(Args&&... args) {
+        static_assert(std::is_base_of_v<Expression, T>, "The arena only holds Expression nodes");
+        static_assert(sizeof(T) <= FirstBlockSize, "Node larger than an arena block");
+        constexpr bool owning = ownsState<T, Args...>;
+        if constexpr (owning) {
+            owners.push_back(nullptr);  // Grow the list first so recording the node cannot throw
+        }
+        T* node;
+        try {
+            node = new (allocate(sizeof(T), alignof(T))) T(link(std::forward<Args>(args))...);
+        } catch (...) {
+            if constexpr (owning) {
+                owners.pop_back();
+            }
+            throw;
+        }
+        if constexpr (owning) {
+            owners.back() = node;
+        }
+        ++nodes;
+        return ArenaRef<T>(node);
+    }
+
+    // Destroys the nodes that own state, releases the rest wholesale and keeps
+    // only the largest block for reuse
+    void reset() {
+        for (auto node = owners.rbegin(); node != owners.rend(); ++node) {
+            (*node)->~Expression();
+        }
+        owners.clear();
+        nodes = 0;
+        if (!blocks.empty()) {
+            blocks.erase(blocks.begin(), blocks.end() - 1);
+            cursor = blocks.back().get();
+            remaining = blockSize;
+        }
+    }
+
+    size_t nodeCount() const {
+        return nodes;
+    }
+};
+
+// The parsed tree points into its arena, so the two travel together
+struct ParsedExpression {
+    std::unique_ptr<ExpressionArena> arena;
+    ArenaRef<Expression> root;
+    std::unordered_map<std::string, Variable*> variables;  // One node per free identifier
+};
+
+// Grammar (usual precedence, left-associative):
+//   expression := term (('+' | '-') term)*
+//   term       := factor ('*' factor)*
+//   factor     := number | identifier | '(' expression ')' | '-' factor
+// Identifiers with a value in the bindings become constants at parse time;
+// any other identifier becomes a Variable, shared by every use of the name.
+// Parentheses and unary minus recurse, so their nesting is capped at
+// MaxNesting to keep hostile input from overflowing the stack.
+class ExpressionParser {
+public:
+    static constexpr size_t MaxNesting = 1000;
+
+private:
+    std::string_view text;
+    size_t position = 0;
+    size_t nesting = 0;
+    const std::unordered_map<std::string, int>& bindings;
+    ParsedExpression& parsed;
+
+    ExpressionParser(std::string_view text, const std::unordered_map<std::string, int>& bindings,
+                     ParsedExpression& parsed)
+        : text(text), bindings(bindings), parsed(parsed) {}
+
+    [[noreturn]] void fail(const std::string& message) const {
+        throw std::invalid_argument("Parse error at offset " + std::to_string(position) + ": " + message);
+    }
+
+    char peek() {
+        while (position < text.size() && std::isspace(static_cast<unsigned char>(text[position]))) {
+            ++position;
+        }
+        return position < text.size() ? text[position] : '\0';
+    }
+
+    ArenaRef<Expression> parseExpression() {
+        auto left = parseTerm();
+        for (char op = peek(); op == '+' || op == '-'; op = peek()) {
+            ++position;
+            auto right = parseTerm();
+            left = op == '+' ? ArenaRef<Expression>(parsed.arena->make<Add>(left, right))
+                             : parsed.arena->make<Subtract>(left, right);
+        }
+        return left;
+    }
+
+    ArenaRef<Expression> parseTerm() {
+        auto left = parseFactor();
+        while (peek() == '*') {
+            ++position;
+            left = parsed.arena->make<Multiply>(left, parseFactor());
+        }
+        return left;
+    }
+
+    ArenaRef<Expression> parseFactor() {
+        char c = peek();
+        if (c == '(' || c == '-') {
+            if (nesting == MaxNesting) {
+                fail("nesting deeper than " + std::to_string(MaxNesting));
+            }
+            ++nesting;
+            ++position;
+            ArenaRef<Expression> result;
+            if (c == '(') {
+                result = parseExpression();
+                if (peek() != ')') {
+                    fail("expected ')'");
+                }
+                ++position;
+            } else {
+                result = parsed.arena->make<Subtract>(parsed.arena->make<Number>(0), parseFactor());
+            }
+            --nesting;
+            return result;
+        }
+        if (std::isdigit(static_cast<unsigned char>(c))) {
+            long long value = 0;
+            while (position < text.size() && std::isdigit(static_cast<unsigned char>(text[position]))) {
+                value = value * 10 + (text[position++] - '0');
+                if (value > INT_MAX) {
+                    fail("integer literal out of range");
+                }
+            }
+            return parsed.arena->make<Number>(static_cast<int>(value));
+        }
+        if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+            size_t start = position;
+            while (position < text.size() &&
+                   (std::isalnum(static_cast<unsigned char>(text[position])) || text[position] == '_')) {
+                ++position;
+            }
+            std::string name(text.substr(start, position - start));
+            auto binding = bindings.find(name);
+            if (binding != bindings.end()) {
+                return parsed.arena->make<Number>(binding->second);
+            }
+            auto [entry, inserted] = parsed.variables.try_emplace(name, nullptr);
+            if (inserted) {
+                entry->second = parsed.arena->make<Variable>(name).get();
+            }
+            return ArenaRef<Expression>(entry->second);
+        }
+        fail(c == '\0' ? "unexpected end of input" : std::string("unexpected '") + c + "'");
+    }
+
+public:
+    static ParsedExpression parse(std::string_view text,
+                                  const std::unordered_map<std::string, int>& bindings = {}) {
+        ParsedExpression parsed{std::make_unique<ExpressionArena>(), {}, {}};
+        ExpressionParser parser(text, bindings, parsed);
+        parsed.root = parser.parseExpression();
+        if (parser.peek() != '\0') {
+            parser.fail("trailing input");
+        }
+        return parsed;
+    }
+};
+
+// Step 6: Optimize an Expression tree into a hash-consed DAG
+// Structurally identical subtrees are interned to a single node (hash-consing)
+// and subtrees whose operands are all constant are evaluated ahead of time,
+// along with the identities x + 0, x - 0, x * 1 and x * 0. Nodes are stored
+// children-first, so evaluate() is one pass that computes every unique node
+// exactly once and reuses that result wherever the subtree was repeated.
+// Input nodes shared by pointer are only visited once while building.
+class ExpressionDag {
+public:
+    enum class Kind : uint8_t { Constant, Variable, Add, Subtract, Multiply };
+
+    struct Node {
+        Kind kind;
+        int value;       // Constant: the value; Variable: index into getVariables()
+        uint32_t left;   // Operations only: indices of earlier nodes
+        uint32_t right;
+    };
+
+private:
+    struct NodeHash {
+        size_t operator()(const Node& node) const {
+            uint64_t h = static_cast<uint64_t>(node.kind) * 0x9E3779B97F4A7C15ull;
+            h ^= (static_cast<uint64_t>(static_cast<uint32_t>(node.value)) + (h << 6) + (h >> 2));
+            h ^= (static_cast<uint64_t>(node.left) << 32 | node.right) * 0xC2B2AE3D27D4EB4Full;
+            return static_cast<size_t>(h ^ (h >> 29));
+        }
+    };
+
+    struct NodeEqual {
+        bool operator()(const Node& a, const Node& b) const {
+            return a.kind == b.kind && a.value == b.value && a.left == b.left && a.right == b.right;
+        }
+    };
+
+    std::vector<Node> nodes;
+    std::vector<std::string> variables;
+    uint32_t root = 0;
+
+    class Builder;
+
+    static bool isOperation(Kind kind) {
+        return kind != Kind::Constant && kind != Kind::Variable;
+    }
+
+public:
+    static ExpressionDag build(const Expression& expression, bool foldConstants = true);
+
+    // Variable values are passed in getVariables() order
+    int evaluate(std::span<const int> variableValues = {}) const {
+        if (variableValues.size() != variables.size()) {
+            throw std::invalid_argument("ExpressionDag: expected " + std::to_string(variables.size()) +
+                                        " variable values");
+        }
+        std::vector<int> results(nodes.size());
+        for (size_t index = 0; index < nodes.size(); ++index) {
+            const Node& node = nodes[index];
+            switch (node.kind) {
+            case Kind::Constant: results[index] = node.value; break;
+            case Kind::Variable: results[index] = variableValues[node.value]; break;
+            case Kind::Add:      results[index] = wrappingAdd(results[node.left], results[node.right]); break;
+            case Kind::Subtract: results[index] = wrappingSubtract(results[node.left], results[node.right]); break;
+            case Kind::Multiply: results[index] = wrappingMultiply(results[node.left], results[node.right]); break;
+            }
+        }
+        return results[root];
+    }
+
+    // Lower the DAG to bytecode: constants and variables become input
+    // registers and every shared operation is computed once into its own one
+    BytecodeProgram compile() const {
+        BytecodeProgram program;
+        program.variables = variables;
+        std::vector<uint32_t> registers(nodes.size());
+        for (size_t index = 0; index < nodes.size(); ++index) {
+            if (nodes[index].kind == Kind::Constant) {
+                registers[index] = static_cast<uint32_t>(program.constants.size());
+                program.constants.push_back(nodes[index].value);
+            }
+        }
+        uint32_t next = static_cast<uint32_t>(program.constants.size());
+        for (size_t index = 0; index < nodes.size(); ++index) {
+            if (nodes[index].kind == Kind::Variable) {
+                registers[index] = next + static_cast<uint32_t>(nodes[index].value);
+            }
+        }
+        next += static_cast<uint32_t>(variables.size());
+        for (size_t index = 0; index < nodes.size(); ++index) {
+            const Node& node = nodes[index];
+            if (!isOperation(node.kind)) {
+                continue;
+            }
+            OpCode op = node.kind == Kind::Add ? OpCode::Add
+                      : node.kind == Kind::Subtract ? OpCode::Subtract
+                      : OpCode::Multiply;
+            program.code.push_back({op, registers[node.left], registers[node.right]});
+            registers[index] = next++;
+        }
+        program.result = registers[root];
+        return program;
+    }
+
+    // Rebuild an Expression in which repeated subtrees are the same object
+    std::shared_ptr<Expression> toExpression() const {
+        std::vector<std::shared_ptr<Expression>> built(nodes.size());
+        for (size_t index = 0; index < nodes.size(); ++index) {
+            const Node& node = nodes[index];
+            switch (node.kind) {
+            case Kind::Constant: built[index] = std::make_shared<Number>(node.value); break;
+            case Kind::Variable: built[index] = std::make_shared<Variable>(variables[node.value]); break;
+            case Kind::Add:      built[index] = std::make_shared<Add>(built[node.left], built[node.right]); break;
+            case Kind::Subtract: built[index] = std::make_shared<Subtract>(built[node.left], built[node.right]); break;
+            case Kind::Multiply: built[index] = std::make_shared<Multiply>(built[node.left], built[node.right]); break;
+            }
+        }
+        return built[root];
+    }
+
+    size_t uniqueNodes() const {
+        return nodes.size();
+    }
+
+    const std::vector<Node>& getNodes() const {
+        return nodes;
+    }
+
+    uint32_t getRoot() const {
+        return root;
+    }
+
+    const std::vector<std::string>& getVariables() const {
+        return variables;
+    }
+};
+
+class ExpressionDag::Builder : public ExpressionVisitor {
+private:
+    ExpressionDag& dag;
+    bool foldConstants;
+    std::unordered_map<Node, uint32_t, NodeHash, NodeEqual> interned;
+    std::unordered_map<const Expression*, uint32_t> visited;
+    std::unordered_map<std::string, int> variableIndices;
+    uint32_t result = 0;
+
+    uint32_t intern(const Node& node) {
+        auto [entry, inserted] = interned.try_emplace(node, static_cast<uint32_t>(dag.nodes.size()));
+        if (inserted) {
+            dag.nodes.push_back(node);
+        }
+        return entry->second;
+    }
+
+    uint32_t constant(int value) {
+        return intern({Kind::Constant, value, 0, 0});
+    }
+
+    bool isConstant(uint32_t index, int* value = nullptr) const {
+        const Node& node = dag.nodes[index];
+        if (node.kind != Kind::Constant) return false;
+        if (value) *value = node.value;
+        return true;
+    }
+
+    uint32_t operation(Kind kind, const Expression& leftExpression, const Expression& rightExpression) {
+        uint32_t left = of(leftExpression);
+        uint32_t right = of(rightExpression);
+
+        if (foldConstants) {
+            int a = 0, b = 0;
+            bool leftConstant = isConstant(left, &a);
+            bool rightConstant = isConstant(right, &b);
+            if (leftConstant && rightConstant) {
+                switch (kind) {
+                case Kind::Add:      return constant(wrappingAdd(a, b));
+                case Kind::Subtract: return constant(wrappingSubtract(a, b));
+                default:             return constant(wrappingMultiply(a, b));
+                }
+            }
+            if (kind == Kind::Add && leftConstant && a == 0) return right;
+            if ((kind == Kind::Add || kind == Kind::Subtract) && rightConstant && b == 0) return left;
+            if (kind == Kind::Multiply && ((leftConstant && a == 0) || (rightConstant && b == 0))) return constant(0);
+            if (kind == Kind::Multiply && leftConstant && a == 1) return right;
+            if (kind == Kind::Multiply && rightConstant && b == 1) return left;
+        }
+        return intern({kind, 0, left, right});
+    }
+
+public:
+    Builder(ExpressionDag& dag, bool foldConstants) : dag(dag), foldConstants(foldConstants) {}
+
+    uint32_t of(const Expression& expression) {
+        auto known = visited.find(&expression);
+        if (known != visited.end()) {
+            return known->second;
+        }
+        expression.accept(*this);
+        visited.emplace(&expression, result);
+        return result;
+    }
+
+    void visit(const Number& number) override {
+        result = constant(number.getValue());
+    }
+
+    void visit(const Variable& variable) override {
+        auto [entry, inserted] = variableIndices.try_emplace(
+            variable.getName(), static_cast<int>(dag.variables.size()));
+        if (inserted) {
+            dag.variables.push_back(variable.getName());
+        }
+        result = intern({Kind::Variable, entry->second, 0, 0});
+    }
+
+    void visit(const Add& add) override {
+        result = operation(Kind::Add, *add.getLeft(), *add.getRight());
+    }
+
+    void visit(const Subtract& subtract) override {
+        result = operation(Kind::Subtract, *subtract.getLeft(), *subtract.getRight());
+    }
+
+    void visit(const Multiply& multiply) override {
+        result = operation(Kind::Multiply, *multiply.getLeft(), *multiply.getRight());
+    }
+};
+
+inline ExpressionDag ExpressionDag::build(const Expression& expression, bool foldConstants) {
+    ExpressionDag dag;
+    Builder builder(dag, foldConstants);
+    dag.root = builder.of(expression);
+
+    // Folding leaves the operands it consumed behind; keep only what the root reaches
+    std::vector<uint32_t> remap(dag.nodes.size(), UINT32_MAX);
+    std::vector<bool> reachable(dag.nodes.size(), false);
+    reachable[dag.root] = true;
+    for (size_t index = dag.nodes.size(); index-- > 0;) {
+        if (reachable[index] && isOperation(dag.nodes[index].kind)) {
+            reachable[dag.nodes[index].left] = true;
+            reachable[dag.nodes[index].right] = true;
+        }
+    }
+    std::vector<Node> kept;
+    for (size_t index = 0; index < dag.nodes.size(); ++index) {
+        if (!reachable[index]) continue;
+        Node node = dag.nodes[index];
+        if (isOperation(node.kind)) {
+            node.left = remap[node.left];
+            node.right = remap[node.right];
+        }
+        remap[index] = static_cast<uint32_t>(kept.size());
+        kept.push_back(node);
+    }
+    dag.nodes = std::move(kept);
+    dag.root = remap[dag.root];
+    return dag;
+}
+
+// Step 7: Evaluate one expression over whole columns of variable values
+// The expression is first reduced to its DAG, then evaluated one block of
+// rows at a time: each unique node becomes one tight loop over the block
+// (AVX2 when the CPU has it, scalar otherwise) instead of one virtual call
+// per node per row. Only nodes reachable from the root are evaluated. Each
+// constant keeps one broadcast block; operations share a pool of blocks, and
+// an operation's block goes back to the pool once its last consumer has run,
+// so scratch grows with the widest point of the DAG rather than its size.
+// Arithmetic wraps modulo 2^32 in both kernels.
+namespace column_kernels {
+
+using Kernel = void (*)(const int* left, const int* right, int* out, size_t count);
+
+inline void addScalar(const int* left, const int* right, int* out, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = wrappingAdd(left[i], right[i]);
+    }
+}
+
+inline void subtractScalar(const int* left, const int* right, int* out, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = wrappingSubtract(left[i], right[i]);
+    }
+}
+
+inline void multiplyScalar(const int* left, const int* right, int* out, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = wrappingMultiply(left[i], right[i]);
+    }
+}
+
+#ifdef INTERPRETER_HAVE_AVX2
+__attribute__((target("avx2"))) inline void addAvx2(const int* left, const int* right, int* out, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(left + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(right + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_add_epi32(a, b));
+    }
+    addScalar(left + i, right + i, out + i, count - i);
+}
+
+__attribute__((target("avx2"))) inline void subtractAvx2(const int* left, const int* right, int* out, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(left + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(right + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_sub_epi32(a, b));
+    }
+    subtractScalar(left + i, right + i, out + i, count - i);
+}
+
+__attribute__((target("avx2"))) inline void multiplyAvx2(const int* left, const int* right, int* out, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(left + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(right + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_mullo_epi32(a, b));
+    }
+    multiplyScalar(left + i, right + i, out + i, count - i);
+}
+#endif
+
+struct KernelTable {
+    Kernel add;
+    Kernel subtract;
+    Kernel multiply;
+    const char* name;
+};
+
+inline const KernelTable& kernels() {
+    static const KernelTable table = [] {
+#ifdef INTERPRETER_HAVE_AVX2
+        if (__builtin_cpu_supports("avx2")) {
+            return KernelTable{addAvx2, subtractAvx2, multiplyAvx2, "AVX2"};
+        }
+#endif
+        return KernelTable{addScalar, subtractScalar, multiplyScalar, "scalar"};
+    }();
+    return table;
+}
+
+}  // namespace column_kernels
+
+class ColumnEvaluator {
+private:
+    static constexpr size_t BlockRows = 1024;
+    static constexpr uint32_t NoBlock = UINT32_MAX;
+
+    ExpressionDag dag;
+    std::vector<bool> reachable;
+    std::vector<uint32_t> blocks;  // Scratch block of each constant and operation
+    size_t blockCount = 0;
+
+    static bool isOperation(ExpressionDag::Kind kind) {
+        return kind != ExpressionDag::Kind::Constant && kind != ExpressionDag::Kind::Variable;
+    }
+
+    // Children always precede their parents in the DAG, so one backward pass
+    // finds the live nodes and one forward pass assigns blocks
+    void planBlocks() {
+        using Kind = ExpressionDag::Kind;
+        const auto& nodes = dag.getNodes();
+        uint32_t root = dag.getRoot();
+        reachable.assign(nodes.size(), false);
+        blocks.assign(nodes.size(), NoBlock);
+        reachable[root] = true;
+        for (size_t index = root + 1; index-- > 0;) {
+            if (reachable[index] && isOperation(nodes[index].kind)) {
+                reachable[nodes[index].left] = true;
+                reachable[nodes[index].right] = true;
+            }
+        }
+
+        std::vector<uint32_t> lastUse(nodes.size(), 0);
+        for (uint32_t index = 0; index <= root; ++index) {
+            if (reachable[index] && isOperation(nodes[index].kind)) {
+                lastUse[nodes[index].left] = index;
+                lastUse[nodes[index].right] = index;
+            }
+        }
+
+        std::vector<uint32_t> freeBlocks;
+        auto release = [&](uint32_t child, uint32_t consumer) {
+            if (isOperation(nodes[child].kind) && lastUse[child] == consumer) {
+                freeBlocks.push_back(blocks[child]);
+            }
+        };
+        for (uint32_t index = 0; index <= root; ++index) {
+            const auto& node = nodes[index];
+            if (!reachable[index] || node.kind == Kind::Variable) {
+                continue;
+            }
+            if (node.kind == Kind::Constant) {
+                blocks[index] = static_cast<uint32_t>(blockCount++);
+                continue;
+            }
+            if (index != root) {  // The root writes straight into the results
+                if (freeBlocks.empty()) {
+                    blocks[index] = static_cast<uint32_t>(blockCount++);
+                } else {
+                    blocks[index] = freeBlocks.back();
+                    freeBlocks.pop_back();
+                }
+            }
+            // Operands are released only after the output block is taken, so
+            // no kernel writes over one of its own inputs
+            release(node.left, index);
+            if (node.right != node.left) {
+                release(node.right, index);
+            }
+        }
+    }
+
+public:
+    explicit ColumnEvaluator(const Expression& expression) : dag(ExpressionDag::build(expression)) {
+        planBlocks();
+    }
+
+    // Column i holds the values of getVariables()[i], one per row
+    const std::vector<std::string>& getVariables() const {
+        return dag.getVariables();
+    }
+
+    std::vector<int> evaluate(std::span<const std::span<const int>> columns, size_t rows) const {
+        std::vector<int> results(rows);
+        evaluate(columns, results);
+        return results;
+    }
+
+    void evaluate(std::span<const std::span<const int>> columns, std::span<int> results) const {
+        using Kind = ExpressionDag::Kind;
+        const auto& nodes = dag.getNodes();
+        const auto& table = column_kernels::kernels();
+        size_t rows = results.size();
+
+        if (columns.size() != dag.getVariables().size()) {
+            throw std::invalid_argument("ColumnEvaluator: expected " +
+                                        std::to_string(dag.getVariables().size()) + " columns");
+        }
+        for (const auto& column : columns) {
+            if (column.size() < rows) {
+                throw std::invalid_argument("ColumnEvaluator: column shorter than the result");
+            }
+        }
+
+        // Constants are broadcast once; operations reuse blocks as planned
+        std::vector<int> scratch(blockCount * BlockRows);
+        std::vector<const int*> operand(nodes.size());
+        uint32_t root = dag.getRoot();
+        for (uint32_t index = 0; index <= root; ++index) {
+            if (reachable[index] && nodes[index].kind == Kind::Constant) {
+                int* block = scratch.data() + blocks[index] * BlockRows;
+                std::fill_n(block, BlockRows, nodes[index].value);
+                operand[index] = block;
+            }
+        }
+
+        for (size_t start = 0; start < rows; start += BlockRows) {
+            size_t count = std::min(BlockRows, rows - start);
+            for (uint32_t index = 0; index <= root; ++index) {
+                const auto& node = nodes[index];
+                if (!reachable[index] || node.kind == Kind::Constant) {
+                    continue;
+                }
+                if (node.kind == Kind::Variable) {
+                    operand[index] = columns[node.value].data() + start;
+                    continue;
+                }
+
+                int* out = index == root ? results.data() + start : scratch.data() + blocks[index] * BlockRows;
+                column_kernels::Kernel kernel = node.kind == Kind::Add ? table.add
+                                              : node.kind == Kind::Subtract ? table.subtract
+                                              : table.multiply;
+                kernel(operand[node.left], operand[node.right], out, count);
+                operand[index] = out;
+            }
+
+            if (!isOperation(nodes[root].kind)) {
+                std::copy_n(operand[root], count, results.data() + start);
+            }
+        }
+    }
+
+    // Blocks of BlockRows ints that evaluate() allocates per call
+    size_t scratchBlocks() const {
+        return blockCount;
+    }
+};
+
+// Step 8: JIT-compile an expression to native x86-64 code
+// The expression is reduced to its DAG and every operation is emitted as
+//   mov eax, <left>; add/sub/imul eax, <right>; mov [rsi + slot], eax
+// where operands are immediates (constants), [rdi + 4 * i] (variables) or
+// slots (earlier operations). The code is written to an anonymous mapping
+// which is then flipped from writable to executable, and called as
+// int(const int* variables, int* slots) through the System V calling
+// convention. Slots live in a caller-provided buffer rather than the native
+// stack, so a DAG with millions of operations cannot overrun the stack.
+// On other hosts, or if the mapping fails, evaluation falls back to the DAG.
+class JitExpression {
+public:
+    using Function = int (*)(const int* variables, int* slots);
+
+private:
+    static constexpr size_t LocalSlots = 1024;  // Buffers up to this size live on the caller's stack
+
+    ExpressionDag dag;
+    void* code = nullptr;
+    size_t codeSize = 0;
+    size_t slotCount = 0;
+    Function function = nullptr;
+
+#ifdef INTERPRETER_HAVE_JIT
+    class Assembler {
+    private:
+        std::vector<uint8_t> bytes;
+
+        void imm32(uint32_t value) {
+            for (int shift = 0; shift < 32; shift += 8) {
+                bytes.push_back(static_cast<uint8_t>(value >> shift));
+            }
+        }
+
+    public:
+        enum class Base { Immediate, Variables, Slots };
+
+        struct Operand {
+            Base base;
+            uint32_t value;  // Immediate value or byte displacement
+        };
+
+        // Emit <opcode bytes> with a ModRM selecting eax and the operand
+        void withOperand(std::initializer_list<uint8_t> opcode, const Operand& operand) {
+            bytes.insert(bytes.end(), opcode);
+            bytes.push_back(operand.base == Base::Variables ? 0x87    // ModRM: eax, [rdi + disp32]
+                                                            : 0x86);  // ModRM: eax, [rsi + disp32]
+            imm32(operand.value);
+        }
+
+        void load(const Operand& operand) {
+            if (operand.base == Base::Immediate) {
+                bytes.push_back(0xB8);        // mov eax, imm32
+                imm32(operand.value);
+            } else {
+                withOperand({0x8B}, operand); // mov eax, r/m32
+            }
+        }
+
+        void apply(ExpressionDag::Kind kind, const Operand& operand) {
+            using Kind = ExpressionDag::Kind;
+            if (operand.base == Base::Immediate) {
+                if (kind == Kind::Add)      bytes.push_back(0x05);                               // add eax, imm32
+                if (kind == Kind::Subtract) bytes.push_back(0x2D);                               // sub eax, imm32
+                if (kind == Kind::Multiply) bytes.insert(bytes.end(), {uint8_t(0x69), uint8_t(0xC0)}); // imul eax, eax, imm32
+                imm32(operand.value);
+                return;
+            }
+            if (kind == Kind::Add)      withOperand({0x03}, operand);        // add eax, r/m32
+            if (kind == Kind::Subtract) withOperand({0x2B}, operand);        // sub eax, r/m32
+            if (kind == Kind::Multiply) withOperand({0x0F, 0xAF}, operand);  // imul eax, r/m32
+        }
+
+        void store(uint32_t displacement) {
+            withOperand({0x89}, {Base::Slots, displacement});  // mov [rsi + disp32], eax
+        }
+
+        void ret() {
+            bytes.push_back(0xC3);
+        }
+
+        const std::vector<uint8_t>& code() const {
+            return bytes;
+        }
+    };
+
+    void emit() {
+        using Kind = ExpressionDag::Kind;
+        using Operand = Assembler::Operand;
+        using Base = Assembler::Base;
+
+        const auto& nodes = dag.getNodes();
+        std::vector<Operand> operands(nodes.size());
+        size_t slots = 0;
+        for (size_t index = 0; index < nodes.size(); ++index) {
+            const auto& node = nodes[index];
+            if (node.kind == Kind::Constant) {
+                operands[index] = {Base::Immediate, static_cast<uint32_t>(node.value)};
+            } else if (node.kind == Kind::Variable) {
+                operands[index] = {Base::Variables, static_cast<uint32_t>(node.value) * 4};
+            } else {
+                operands[index] = {Base::Slots, static_cast<uint32_t>(slots * 4)};
+                ++slots;
+            }
+        }
+        if (slots > INT32_MAX / 4) {
+            return;  // Displacements are 32-bit; leave it to the DAG
+        }
+
+        Assembler assembler;
+        for (size_t index = 0; index < nodes.size(); ++index) {
+            const auto& node = nodes[index];
+            if (node.kind == Kind::Constant || node.kind == Kind::Variable) {
+                continue;
+            }
+            assembler.load(operands[node.left]);
+            assembler.apply(node.kind, operands[node.right]);
+            assembler.store(operands[index].value);
+        }
+        assembler.load(operands[dag.getRoot()]);
+        assembler.ret();
+
+        const auto& bytes = assembler.code();
+        void* memory = mmap(nullptr, bytes.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            return;
+        }
+        std::copy(bytes.begin(), bytes.end(), static_cast<uint8_t*>(memory));
+        if (mprotect(memory, bytes.size(), PROT_READ | PROT_EXEC) != 0) {
+            munmap(memory, bytes.size());
+            return;
+        }
+        code = memory;
+        codeSize = bytes.size();
+        slotCount = slots;
+        function = reinterpret_cast<Function>(memory);
+    }
+#endif
+
+public:
+    explicit JitExpression(const Expression& expression) : dag(ExpressionDag::build(expression)) {
+#ifdef INTERPRETER_HAVE_JIT
+        emit();
+#endif
+    }
+
+    ~JitExpression() {
+#ifdef INTERPRETER_HAVE_JIT
+        if (code) {
+            munmap(code, codeSize);
+        }
+#endif
+    }
+
+    JitExpression(const JitExpression&) = delete;
+    JitExpression& operator=(const JitExpression&) = delete;
+
+    // Variable values are passed in getVariables() order
+    int operator()(std::span<const int> variableValues = {}) const {
+        if (function && variableValues.size() == dag.getVariables().size()) {
+            if (slotCount <= LocalSlots) {
+                int slots[LocalSlots];
+                return function(variableValues.data(), slots);
+            }
+            static thread_local std::vector<int> slots;
+            if (slots.size() < slotCount) {
+                slots.resize(slotCount);
+            }
+            return function(variableValues.data(), slots.data());
+        }
+        return dag.evaluate(variableValues);
+    }
+
+    // The raw native entry point, or nullptr when running on the fallback.
+    // Its slots argument must point to getSlotCount() writable ints.
+    Function getFunction() const {
+        return function;
+    }
+
+    size_t getSlotCount() const {
+        return slotCount;
+    }
+
+    bool isNative() const {
+        return function != nullptr;
+    }
+
+    size_t getCodeSize() const {
+        return codeSize;
+    }
+
+    const std::vector<std::string>& getVariables() const {
+        return dag.getVariables();
+    }
+};
+
+// Step 9: Benchmarks
+// 9a: interpret() against compile-once, run-many bytecode
+// Random trees mix all three operations over small constants. Deep products
+// overflow int, and both paths wrap them modulo 2^32, so they must agree.
+std::shared_ptr<Expression> randomExpression(int depth, uint32_t& seed) {
+    seed = seed * 1664525u + 1013904223u;
+    if (depth == 0 || (depth < 8 && (seed >> 28) < 3)) {
+        return std::make_shared<Number>(static_cast<int>((seed >> 8) % 10));
+    }
+    auto left = randomExpression(depth - 1, seed);
+    auto right = randomExpression(depth - 1, seed);
+    switch ((seed >> 16) % 3) {
+    case 0:  return std::make_shared<Add>(left, right);
+    case 1:  return std::make_shared<Subtract>(left, right);
+    default: return std::make_shared<Multiply>(left, right);
+    }
+}
+
+void benchmarkBytecode() {
+    uint32_t seed = 2024;
+    auto expression = randomExpression(10, seed);
+    const int evaluations = 100000;
+
+    auto start = std::chrono::steady_clock::now();
+    BytecodeProgram program = BytecodeCompiler::compile(*expression);
+    double compileSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    long long treeSum = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < evaluations; ++i) {
+        treeSum += expression->interpret();
+    }
+    double treeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    long long vmSum = 0;
+    std::vector<int> registers(program.registerCount());
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < evaluations; ++i) {
+        vmSum += program.run({}, registers.data());
+    }
+    double vmSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Expression compiled to " << program.size() << " instructions in "
+              << compileSeconds * 1e6 << " us" << std::endl;
+    std::cout << "interpret(): " << treeSeconds * 1e9 / evaluations << " ns/evaluation" << std::endl;
+    std::cout << "bytecode:    " << vmSeconds * 1e9 / evaluations << " ns/evaluation ("
+              << treeSeconds / vmSeconds << "x)" << std::endl;
+    if (treeSum != vmSum) {
+        std::cout << "Mismatch between interpret() and bytecode!" << std::endl;
+    }
+}
+
+// 9b: Parser throughput on a large generated input
+// The generator nests balanced sub-expressions so the tree stays shallow
+// enough to interpret recursively while the text runs to several megabytes.
+void generateExpressionText(int depth, uint32_t& seed, std::string& out) {
+    seed = seed * 1664525u + 1013904223u;
+    if (depth == 0) {
+        if ((seed >> 30) == 0) {
+            out += 'x';
+        } else {
+            out += std::to_string((seed >> 8) % 100);
+        }
+        return;
+    }
+    static const char* operators[] = {" + ", " - ", " * "};
+    out += '(';
+    generateExpressionText(depth - 1, seed, out);
+    out += operators[(seed >> 16) % 3];
+    generateExpressionText(depth - 1, seed, out);
+    out += ')';
+}
+
+void benchmarkParser() {
+    std::string text;
+    uint32_t seed = 7;
+    generateExpressionText(20, seed, text);
+    std::unordered_map<std::string, int> bindings = {{"x", 3}};
+
+    auto start = std::chrono::steady_clock::now();
+    ParsedExpression parsed = ExpressionParser::parse(text, bindings);
+    double parseSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t nodes = parsed.arena->nodeCount();
+    std::cout << "Parsed " << text.size() / (1024.0 * 1024.0) << " MB into " << nodes << " nodes in "
+              << parseSeconds * 1e3 << " ms (" << text.size() / parseSeconds / (1024.0 * 1024.0) << " MB/s, "
+              << nodes / parseSeconds / 1e6 << " M nodes/s)" << std::endl;
+
+    start = std::chrono::steady_clock::now();
+    parsed = ParsedExpression{};
+    double releaseSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Released the arena in " << releaseSeconds * 1e6 << " us" << std::endl;
+}
+
+// 9c: Evaluation cost of a tree full of repeated subtrees
+// Children are generated from a small pool of seeds, so the same subtrees
+// appear over and over as separate objects.
+std::shared_ptr<Expression> repetitiveExpression(int depth, uint32_t seed) {
+    if (depth == 0) {
+        return std::make_shared<Number>(static_cast<int>(seed % 10));
+    }
+    uint32_t next = seed * 1664525u + 1013904223u;
+    auto left = repetitiveExpression(depth - 1, (next >> 8) % 4);
+    auto right = repetitiveExpression(depth - 1, (next >> 16) % 4);
+    switch (next % 3) {
+    case 0:  return std::make_shared<Add>(left, right);
+    case 1:  return std::make_shared<Subtract>(left, right);
+    default: return std::make_shared<Multiply>(left, right);
+    }
+}
+
+void benchmarkDag() {
+    auto expression = repetitiveExpression(18, 1);
+    const int evaluations = 20;
+
+    auto start = std::chrono::steady_clock::now();
+    int treeResult = 0;
+    for (int i = 0; i < evaluations; ++i) {
+        treeResult = expression->interpret();
+    }
+    double treeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Tree: " << ((1 << 19) - 1) << " nodes, " << treeSeconds * 1e6 / evaluations
+              << " us/evaluation" << std::endl;
+
+    for (bool fold : {false, true}) {
+        start = std::chrono::steady_clock::now();
+        ExpressionDag dag = ExpressionDag::build(*expression, fold);
+        double buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        int dagResult = 0;
+        for (int i = 0; i < evaluations; ++i) {
+            dagResult = dag.evaluate();
+        }
+        double dagSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << (fold ? "DAG + folding: " : "DAG: ") << dag.uniqueNodes() << " unique nodes, built in "
+                  << buildSeconds * 1e3 << " ms, " << dagSeconds * 1e6 / evaluations << " us/evaluation"
+                  << std::endl;
+        if (dagResult != treeResult) {
+            std::cout << "Mismatch between interpret() and the DAG!" << std::endl;
+        }
+    }
+}
+
+// 9d: One formula over millions of rows, per-row interpret() against columns
+void benchmarkColumns() {
+    const size_t rows = 10000000;
+    ParsedExpression formula = ExpressionParser::parse("(a * 3 + b) * (a - c) + 7 * c - b * b + (a + b + c) * 2");
+    ColumnEvaluator evaluator(*formula.root);
+
+    std::vector<std::vector<int>> data;
+    uint32_t seed = 99;
+    for (size_t column = 0; column < evaluator.getVariables().size(); ++column) {
+        data.emplace_back(rows);
+        for (int& value : data.back()) {
+            seed = seed * 1664525u + 1013904223u;
+            value = static_cast<int>(seed >> 20) - 2048;
+        }
+    }
+
+    std::vector<Variable*> variables;
+    std::vector<std::span<const int>> columns;
+    for (size_t column = 0; column < evaluator.getVariables().size(); ++column) {
+        variables.push_back(formula.variables.at(evaluator.getVariables()[column]));
+        columns.emplace_back(data[column]);
+    }
+
+    std::vector<int> expected(rows);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t row = 0; row < rows; ++row) {
+        for (size_t column = 0; column < variables.size(); ++column) {
+            variables[column]->setValue(data[column][row]);
+        }
+        expected[row] = formula.root->interpret();
+    }
+    double loopSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    std::vector<int> results = evaluator.evaluate(columns, rows);
+    double columnSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "interpret() loop: " << rows / loopSeconds / 1e6 << " M rows/s" << std::endl;
+    std::cout << "columns (" << column_kernels::kernels().name << "): " << rows / columnSeconds / 1e6
+              << " M rows/s (" << loopSeconds / columnSeconds << "x, " << evaluator.scratchBlocks()
+              << " scratch blocks)" << std::endl;
+    if (results != expected) {
+        std::cout << "Mismatch between interpret() and columnar evaluation!" << std::endl;
+    }
+}
+
+// 9e: JIT compile cost against evaluation savings
+// Inputs climb past 46341, where b * b overflows; the reference wraps like the JIT.
+void benchmarkJit() {
+    ParsedExpression formula = ExpressionParser::parse("(a * 3 + b) * (a - c) + 7 * c - b * b + (a + b + c) * 2");
+    const int evaluations = 1000000;
+
+    auto start = std::chrono::steady_clock::now();
+    JitExpression jit(*formula.root);
+    double compileSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<Variable*> variables;
+    for (const auto& name : jit.getVariables()) {
+        variables.push_back(formula.variables.at(name));
+    }
+
+    long long treeSum = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < evaluations; ++i) {
+        for (size_t v = 0; v < variables.size(); ++v) {
+            variables[v]->setValue(i + static_cast<int>(v));
+        }
+        treeSum += formula.root->interpret();
+    }
+    double treeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    long long jitSum = 0;
+    std::vector<int> values(variables.size());
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < evaluations; ++i) {
+        for (size_t v = 0; v < values.size(); ++v) {
+            values[v] = i + static_cast<int>(v);
+        }
+        jitSum += jit(values);
+    }
+    double jitSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double treeNs = treeSeconds * 1e9 / evaluations;
+    double jitNs = jitSeconds * 1e9 / evaluations;
+    std::cout << "JIT (" << (jit.isNative() ? "native" : "fallback") << ", " << jit.getCodeSize()
+              << " bytes) compiled in " << compileSeconds * 1e6 << " us" << std::endl;
+    std::cout << "interpret(): " << treeNs << " ns/evaluation, JIT: " << jitNs << " ns/evaluation" << std::endl;
+    if (treeNs > jitNs) {
+        std::cout << "Break-even after " << static_cast<long long>(compileSeconds * 1e9 / (treeNs - jitNs))
+                  << " evaluations" << std::endl;
+    }
+    if (treeSum != jitSum) {
+        std::cout << "Mismatch between interpret() and the JIT!" << std::endl;
+    }
+}
+
+// Differential test: random expressions over a few variables, JIT against interpret().
+// Half the samples draw variables from [-3, 3], the rest from the full int
+// range so products overflow and both sides must wrap identically.
+std::shared_ptr<Expression> randomVariableExpression(int depth, uint32_t& seed,
+                                                     const std::vector<std::shared_ptr<Variable>>& variables) {
+    seed = seed * 1664525u + 1013904223u;
+    if (depth == 0 || (seed >> 29) == 0) {
+        if ((seed >> 16) % 2 == 0) {
+            return variables[(seed >> 8) % variables.size()];
+        }
+        return std::make_shared<Number>(static_cast<int>((seed >> 8) % 7) - 3);
+    }
+    auto left = randomVariableExpression(depth - 1, seed, variables);
+    auto right = randomVariableExpression(depth - 1, seed, variables);
+    switch ((seed >> 12) % 3) {
+    case 0:  return std::make_shared<Add>(left, right);
+    case 1:  return std::make_shared<Subtract>(left, right);
+    default: return std::make_shared<Multiply>(left, right);
+    }
+}
+
+int testJit() {
+    std::vector<std::shared_ptr<Variable>> variables = {
+        std::make_shared<Variable>("x"), std::make_shared<Variable>("y"), std::make_shared<Variable>("z")};
+    uint32_t seed = 1;
+    int failures = 0;
+
+    for (int round = 0; round < 2000; ++round) {
+        auto expression = randomVariableExpression(4, seed, variables);
+        JitExpression jit(*expression);
+
+        for (int sample = 0; sample < 8; ++sample) {
+            std::unordered_map<std::string, int> inputs;
+            for (auto& variable : variables) {
+                seed = seed * 1664525u + 1013904223u;
+                int value = sample % 2 == 0 ? static_cast<int>((seed >> 8) % 7) - 3 : static_cast<int>(seed);
+                variable->setValue(value);
+                inputs[variable->getName()] = value;
+            }
+            std::vector<int> values;
+            for (const auto& name : jit.getVariables()) {
+                values.push_back(inputs.at(name));
+            }
+            if (jit(values) != expression->interpret()) {
+                ++failures;
+            }
+        }
+    }
+
+    // Millions of unique operations: far more slots than a native stack frame holds
+    std::string text;
+    uint32_t textSeed = 7;
+    generateExpressionText(23, textSeed, text);
+    ParsedExpression large = ExpressionParser::parse(text);
+    for (auto& [name, variable] : large.variables) {
+        variable->setValue(3);
+    }
+    JitExpression largeJit(*large.root);
+    std::vector<int> threes(largeJit.getVariables().size(), 3);
+    if (largeJit(threes) != large.root->interpret()) {
+        ++failures;
+    }
+
+    std::cout << "JIT differential test: " << (failures == 0 ? "passed" : "FAILED") << " ("
+              << failures << " mismatches, " << (JitExpression(Number(0)).isNative() ? "native" : "fallback")
+              << " backend)" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
+
+// Step 10: Client code to interpret expressions
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        benchmarkBytecode();
+        benchmarkParser();
+        benchmarkDag();
+        benchmarkColumns();
+        benchmarkJit();
+        return 0;
+    }
+    if (argc > 1 && std::string(argv[1]) == "--test") {
+        return testJit();
+    }
+
     // Example: (5 + 3) - 2
     std::shared_ptr<Expression> expression = std::make_shared<Subtract>(
         std::make_shared<Add>(
@@ -85,5 +1606,42 @@ int main() {
 
     std::cout << "Result of 2 * (3 + 4): " << expression2->interpret() << std::endl;  // Output: 14
 
+    // Compile once, run many times
+    BytecodeProgram program = BytecodeCompiler::compile(*expression2);
+    std::cout << "Bytecode result of 2 * (3 + 4): " << program.run() << std::endl;  // Output: 14
+
+    // Parse expressions from text instead of nesting constructors by hand
+    ParsedExpression parsed = ExpressionParser::parse("(5 + 3) - 2 * x", {{"x", 4}});
+    std::cout << "Result of (5 + 3) - 2 * x with x = 4: " << parsed.root->interpret() << std::endl;  // Output: 0
+
+    // Share repeated subtrees and fold constants ahead of time
+    ParsedExpression repeated = ExpressionParser::parse("(x * 3 + 1) * (x * 3 + 1) - (x * 3 + 1)", {{"x", 2}});
+    ExpressionDag dag = ExpressionDag::build(*repeated.root, false);
+    std::cout << "DAG of " << repeated.arena->nodeCount() << " parsed nodes has " << dag.uniqueNodes()
+              << " unique nodes, result " << dag.evaluate() << std::endl;  // Output: 17 nodes -> 7, result 42
+    std::cout << "Folded: " << ExpressionDag::build(*repeated.root).uniqueNodes() << " node" << std::endl;  // Output: 1
+
+    // Free identifiers become Variables; evaluate a whole column of x at once
+    ParsedExpression formula = ExpressionParser::parse("(5 + 3) - 2 * x");
+    ColumnEvaluator evaluator(*formula.root);
+    std::vector<int> xs = {0, 1, 2, 3, 4};
+    std::vector<std::span<const int>> columns = {xs};
+    std::cout << "(5 + 3) - 2 * x for x = 0..4:";
+    for (int value : evaluator.evaluate(columns, xs.size())) {
+        std::cout << " " << value;  // Output: 8 6 4 2 0
+    }
+    std::cout << std::endl;
+
+    // JIT-compile the same formula to native code
+    JitExpression jit(*formula.root);
+    std::vector<int> x = {4};
+    std::cout << "JIT " << (jit.isNative() ? "(native)" : "(fallback)") << " with x = 4: " << jit(x) << std::endl;  // Output: 0
+
+    try {
+        ExpressionParser::parse("(5 + ");
+    } catch (const std::invalid_argument& error) {
+        std::cout << error.what() << std::endl;
+    }
+
     return 0;
 }
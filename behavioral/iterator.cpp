@@ -1,15 +1,58 @@
 
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <functional>
 #include <iostream>
-#include <vector>
+#include <iterator>
 #include <memory>
+#include <mutex>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 // Step 1: Define the Iterator interface
+// nextBatch() and nextChunk() pull many elements per virtual call. The
+// default nextBatch() is built on hasNext()/next(); nextChunk() hands out a
+// view of storage the iterator already owns, so each concrete iterator
+// provides it and the interface itself holds no state.
 template <typename T>
 class Iterator {
 public:
     virtual ~Iterator() = default;
     virtual bool hasNext() const = 0;
     virtual T next() = 0;
+
+    // Copy up to out.size() elements into out; returns how many were written
+    virtual size_t nextBatch(std::span<T> out) {
+        size_t count = 0;
+        while (count < out.size() && hasNext()) {
+            out[count++] = next();
+        }
+        return count;
+    }
+
+    // View of up to maxCount next elements; empty once the iterator is
+    // exhausted. The view is valid until the next call on this iterator.
+    virtual std::span<const T> nextChunk(size_t maxCount) = 0;
 };
 
 // Step 2: Create a concrete iterator for a vector
@@ -29,17 +72,140 @@ public:
     T next() override {
         return collection[currentIndex++];
     }
+
+    size_t nextBatch(std::span<T> out) override {
+        size_t count = std::min(out.size(), collection.size() - currentIndex);
+        std::copy_n(collection.begin() + currentIndex, count, out.begin());
+        currentIndex += count;
+        return count;
+    }
+
+    // Zero-copy: the view points straight into the underlying vector
+    std::span<const T> nextChunk(size_t maxCount) override {
+        size_t count = std::min(maxCount, collection.size() - currentIndex);
+        std::span<const T> chunk(collection.data() + currentIndex, count);
+        currentIndex += count;
+        return chunk;
+    }
+};
+
+// Step 3: Define a splittable iterator for parallel traversal
+// trySplit() hands the first half of the remaining elements to a new
+// spliterator and keeps the second half, so a range can be halved
+// recursively across worker threads. position() is the encounter-order index
+// of the next element, which lets parallel algorithms place results.
+// isSized() means estimateSize() is exact, for this spliterator and every
+// piece split from it.
+template <typename T>
+class Spliterator : public Iterator<T> {
+public:
+    virtual size_t estimateSize() const = 0;
+    virtual bool isSized() const {
+        return false;
+    }
+    virtual size_t position() const = 0;
+    virtual std::unique_ptr<Spliterator<T>> trySplit() = 0;
+};
+
+template <typename T>
+class VectorSpliterator : public Spliterator<T> {
+private:
+    const T* data;
+    size_t begin;
+    size_t end;
+
+public:
+    VectorSpliterator(const T* data, size_t begin, size_t end) : data(data), begin(begin), end(end) {}
+
+    bool hasNext() const override {
+        return begin < end;
+    }
+
+    T next() override {
+        return data[begin++];
+    }
+
+    std::span<const T> nextChunk(size_t maxCount) override {
+        size_t count = std::min(maxCount, end - begin);
+        std::span<const T> chunk(data + begin, count);
+        begin += count;
+        return chunk;
+    }
+
+    size_t estimateSize() const override {
+        return end - begin;
+    }
+
+    bool isSized() const override {
+        return true;
+    }
+
+    size_t position() const override {
+        return begin;
+    }
+
+    std::unique_ptr<Spliterator<T>> trySplit() override {
+        size_t middle = begin + (end - begin) / 2;
+        if (middle == begin) {
+            return nullptr;
+        }
+        auto prefix = std::make_unique<VectorSpliterator<T>>(data, begin, middle);
+        begin = middle;
+        return prefix;
+    }
 };
 
-// Step 3: Define the Aggregate interface (collection interface)
+// Wraps a plain Iterator for aggregates that cannot split: it runs serially
+template <typename T>
+class UnsplittableSpliterator : public Spliterator<T> {
+private:
+    std::unique_ptr<Iterator<T>> iterator;
+    size_t consumed = 0;
+
+public:
+    explicit UnsplittableSpliterator(std::unique_ptr<Iterator<T>> iterator) : iterator(std::move(iterator)) {}
+
+    bool hasNext() const override {
+        return iterator->hasNext();
+    }
+
+    T next() override {
+        ++consumed;
+        return iterator->next();
+    }
+
+    std::span<const T> nextChunk(size_t maxCount) override {
+        auto chunk = iterator->nextChunk(maxCount);
+        consumed += chunk.size();
+        return chunk;
+    }
+
+    size_t estimateSize() const override {
+        return hasNext() ? SIZE_MAX : 0;
+    }
+
+    size_t position() const override {
+        return consumed;
+    }
+
+    std::unique_ptr<Spliterator<T>> trySplit() override {
+        return nullptr;
+    }
+};
+
+// Step 4: Define the Aggregate interface (collection interface)
 template <typename T>
 class Aggregate {
 public:
     virtual ~Aggregate() = default;
     virtual std::unique_ptr<Iterator<T>> createIterator() const = 0;
+
+    virtual std::unique_ptr<Spliterator<T>> createSpliterator() const {
+        return std::make_unique<UnsplittableSpliterator<T>>(createIterator());
+    }
 };
 
-// Step 4: Implement a concrete aggregate (vector-based collection)
+// Step 5: Implement a concrete aggregate (vector-based collection)
 template <typename T>
 class VectorCollection : public Aggregate<T> {
 private:
@@ -50,13 +216,1113 @@ public:
         items.push_back(item);
     }
 
+    void reserve(size_t count) {
+        items.reserve(count);
+    }
+
     std::unique_ptr<Iterator<T>> createIterator() const override {
         return std::make_unique<VectorIterator<T>>(items);
     }
+
+    std::unique_ptr<Spliterator<T>> createSpliterator() const override {
+        return std::make_unique<VectorSpliterator<T>>(items.data(), 0, items.size());
+    }
+
+    size_t size() const {
+        return items.size();
+    }
+
+    std::span<const T> view() const {
+        return items;
+    }
+};
+
+// Step 6: Back an aggregate with a memory-mapped file
+// The file is a flat array of fixed-size records. Opening it only maps the
+// file, so startup does not depend on its size; pages fault in as iterators
+// reach them. Iterators prefault the next window ahead of the scan, which
+// batches a window's page faults into one call, and release the window they
+// have passed, so a file larger than RAM streams through a bounded resident set.
+template <typename T>
+class MappedFileIterator : public Iterator<T> {
+private:
+    const T* data;
+    size_t count;
+    size_t currentIndex = 0;
+    size_t windowRecords;   // Read-ahead window in records; 0 disables hints
+    size_t nextWindow = 0;  // Index at which the next hints are issued
+
+    // madvise() needs page-aligned ranges; the mapping itself is page-aligned.
+    // Windows past the end are clamped before any pointer is formed.
+    int advise(size_t first, size_t last, int advice, bool roundEndUp) const {
+        static const uintptr_t pageMask = uintptr_t(sysconf(_SC_PAGESIZE)) - 1;
+        last = std::min(last, count);
+        if (first >= last) {
+            return 0;
+        }
+        uintptr_t begin = reinterpret_cast<uintptr_t>(data + first) & ~pageMask;
+        uintptr_t end = reinterpret_cast<uintptr_t>(data + last);
+        end = roundEndUp ? (end + pageMask) & ~pageMask : end & ~pageMask;
+        return begin < end ? madvise(reinterpret_cast<void*>(begin), end - begin, advice) : 0;
+    }
+
+    // MADV_POPULATE_READ (Linux 5.14) faults the whole window in before it
+    // returns, so the scan blocks once per window instead of once per page.
+    // Older kernels fall back to MADV_WILLNEED, which only starts read-ahead.
+    void readAhead(size_t first, size_t last) const {
+#ifdef MADV_POPULATE_READ
+        if (advise(first, last, MADV_POPULATE_READ, true) == 0) {
+            return;
+        }
+#endif
+        advise(first, last, MADV_WILLNEED, true);
+    }
+
+    // Called before each read, so pages released here never back a chunk
+    // the caller still holds
+    void hintWindows() {
+        if (windowRecords == 0 || currentIndex < nextWindow) {
+            return;
+        }
+        size_t window = currentIndex / windowRecords;
+        readAhead((window + 1) * windowRecords, (window + 2) * windowRecords);
+        if (window > 0) {
+            advise((window - 1) * windowRecords, window * windowRecords, MADV_DONTNEED, false);
+        }
+        nextWindow = (window + 1) * windowRecords;
+    }
+
+public:
+    MappedFileIterator(const T* data, size_t count, size_t windowRecords)
+        : data(data), count(count), windowRecords(windowRecords) {
+        if (windowRecords > 0) {
+            readAhead(0, windowRecords);
+        }
+    }
+
+    bool hasNext() const override {
+        return currentIndex < count;
+    }
+
+    T next() override {
+        hintWindows();
+        return data[currentIndex++];
+    }
+
+    size_t nextBatch(std::span<T> out) override {
+        hintWindows();
+        size_t filled = std::min(out.size(), count - currentIndex);
+        std::copy_n(data + currentIndex, filled, out.begin());
+        currentIndex += filled;
+        return filled;
+    }
+
+    // Zero-copy: the view points straight into the mapped file
+    std::span<const T> nextChunk(size_t maxCount) override {
+        hintWindows();
+        size_t filled = std::min(maxCount, count - currentIndex);
+        std::span<const T> chunk(data + currentIndex, filled);
+        currentIndex += filled;
+        return chunk;
+    }
+};
+
+template <typename T>
+class MappedFileCollection : public Aggregate<T> {
+    static_assert(std::is_trivially_copyable_v<T>, "records are read straight from the file");
+
+private:
+    void* mapping = nullptr;
+    size_t mappedSize = 0;
+    size_t count = 0;
+    size_t readAheadBytes;
+
+    static std::runtime_error systemError(const std::string& what) {
+        return std::runtime_error("MappedFileCollection: " + what + ": " + std::strerror(errno));
+    }
+
+    const T* data() const {
+        return static_cast<const T*>(mapping);
+    }
+
+public:
+    // A trailing partial record, if any, is ignored
+    explicit MappedFileCollection(const std::string& path, size_t readAheadBytes = 8 << 20)
+        : readAheadBytes(readAheadBytes) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw systemError("open " + path);
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            close(fd);
+            throw systemError("fstat");
+        }
+        mappedSize = static_cast<size_t>(info.st_size);
+        count = mappedSize / sizeof(T);
+        if (mappedSize > 0) {
+            mapping = mmap(nullptr, mappedSize, PROT_READ, MAP_SHARED, fd, 0);
+            if (mapping == MAP_FAILED) {
+                mapping = nullptr;
+                close(fd);
+                throw systemError("mmap");
+            }
+            madvise(mapping, mappedSize, MADV_SEQUENTIAL);
+        }
+        close(fd);  // The mapping keeps the file open
+    }
+
+    ~MappedFileCollection() override {
+        if (mapping) {
+            munmap(mapping, mappedSize);
+        }
+    }
+
+    MappedFileCollection(const MappedFileCollection&) = delete;
+    MappedFileCollection& operator=(const MappedFileCollection&) = delete;
+
+    std::unique_ptr<Iterator<T>> createIterator() const override {
+        return std::make_unique<MappedFileIterator<T>>(data(), count, readAheadBytes / sizeof(T));
+    }
+
+    // The mapping is contiguous, so it splits like a vector
+    std::unique_ptr<Spliterator<T>> createSpliterator() const override {
+        return std::make_unique<VectorSpliterator<T>>(data(), 0, count);
+    }
+
+    void setReadAhead(size_t bytes) {
+        readAheadBytes = bytes;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    std::span<const T> view() const {
+        return std::span<const T>(data(), count);
+    }
+};
+
+// Step 7: Run spliterator halves on a work-stealing thread pool
+// Each worker owns a deque: it pushes and pops work at the back, and idle
+// workers steal from the front of the others' deques, where the largest
+// (earliest split) pieces sit. A thread waiting for a parallel algorithm to
+// finish runs queued tasks itself instead of blocking. Threads with nothing
+// to run spin briefly, then sleep in std::atomic::wait on a signal counter
+// that submit(), finish() and shutdown bump, so an idle pool uses no CPU.
+class WorkStealingPool {
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<bool> stopping{false};
+    std::atomic<size_t> queued{0};
+    std::atomic<size_t> nextQueue{0};
+    std::atomic<uint32_t> signals{0};
+    std::atomic<uint32_t> sleepers{0};
+
+    static thread_local WorkStealingPool* currentPool;
+    static thread_local size_t currentIndex;
+
+    bool popOwn(size_t index, std::function<void()>& task) {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        if (queues[index]->tasks.empty()) return false;
+        task = std::move(queues[index]->tasks.back());
+        queues[index]->tasks.pop_back();
+        return true;
+    }
+
+    bool steal(size_t thief, std::function<void()>& task) {
+        for (size_t offset = 1; offset <= queues.size(); ++offset) {
+            Queue& victim = *queues[(thief + offset) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Return once ready() holds or a signal arrives. The counter is read
+    // before ready() is checked, so a signal sent in between makes the wait
+    // return at once instead of being lost.
+    template <typename Ready>
+    void sleepUntil(Ready ready) {
+        for (int spin = 0; spin < 128; ++spin) {
+            if (ready()) {
+                return;
+            }
+        }
+        uint32_t seen = signals.load(std::memory_order_acquire);
+        sleepers.fetch_add(1, std::memory_order_relaxed);
+        // Either signal() sees this sleeper, or ready() sees the progress
+        // published before it
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!ready()) {
+            signals.wait(seen, std::memory_order_acquire);
+        }
+        sleepers.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // Call after publishing progress; a syscall only when a thread sleeps
+    void signal(bool all) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers.load(std::memory_order_relaxed) > 0) {
+            signals.fetch_add(1, std::memory_order_release);
+            if (all) {
+                signals.notify_all();
+            } else {
+                signals.notify_one();
+            }
+        }
+    }
+
+    void workerLoop(size_t index) {
+        currentPool = this;
+        currentIndex = index;
+        while (!stopping.load(std::memory_order_acquire)) {
+            if (!runOne()) {
+                sleepUntil([this] {
+                    return stopping.load(std::memory_order_acquire) || queued.load(std::memory_order_acquire) > 0;
+                });
+            }
+        }
+    }
+
+public:
+    explicit WorkStealingPool(size_t threadCount = std::max(1u, std::thread::hardware_concurrency())) {
+        for (size_t i = 0; i < threadCount; ++i) {
+            queues.push_back(std::make_unique<Queue>());
+        }
+        for (size_t i = 0; i < threadCount; ++i) {
+            workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+        }
+    }
+
+    ~WorkStealingPool() {
+        stopping.store(true, std::memory_order_release);
+        signal(true);
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    size_t threadCount() const {
+        return workers.size();
+    }
+
+    void submit(std::function<void()> task) {
+        size_t index = currentPool == this ? currentIndex : nextQueue.fetch_add(1) % queues.size();
+        {
+            std::lock_guard<std::mutex> lock(queues[index]->mutex);
+            queues[index]->tasks.push_back(std::move(task));
+        }
+        queued.fetch_add(1, std::memory_order_release);
+        signal(false);  // Woken waiters run tasks too, so any sleeper will do
+    }
+
+    // Run one queued task on the calling thread; false if there was none
+    bool runOne() {
+        std::function<void()> task;
+        size_t index = currentPool == this ? currentIndex : 0;
+        if ((currentPool == this && popOwn(index, task)) || steal(index, task)) {
+            queued.fetch_sub(1, std::memory_order_acq_rel);
+            task();
+            return true;
+        }
+        return false;
+    }
+
+    // Count down a task that waitFor() is waiting on
+    void finish(std::atomic<size_t>& pending) {
+        if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            signal(true);  // Workers sleep on the same counter, so wake them all
+        }
+    }
+
+    // Help out until finish() drops the counter to zero
+    void waitFor(const std::atomic<size_t>& pending) {
+        while (pending.load(std::memory_order_acquire) > 0) {
+            if (!runOne()) {
+                sleepUntil([this, &pending] {
+                    return pending.load(std::memory_order_acquire) == 0 ||
+                           queued.load(std::memory_order_acquire) > 0;
+                });
+            }
+        }
+    }
+};
+
+inline thread_local WorkStealingPool* WorkStealingPool::currentPool = nullptr;
+inline thread_local size_t WorkStealingPool::currentIndex = 0;
+
+// Step 8: Parallel algorithms over any Aggregate
+// A task keeps splitting its spliterator, submitting the halves, until the
+// piece is at most LeafSize elements, then streams it with nextChunk().
+namespace parallel_detail {
+
+constexpr size_t LeafSize = 1 << 16;
+constexpr size_t ChunkSize = 4096;
+
+// Calls leaf(spliterator) on pieces of the range from pool threads. A task
+// that throws still counts itself down; pieces not yet started are skipped
+// and the first exception is rethrown here once every task has finished.
+template <typename T, typename Leaf>
+void splitAndRun(WorkStealingPool& pool, std::unique_ptr<Spliterator<T>> root, Leaf& leaf) {
+    std::atomic<size_t> pending{1};
+    std::atomic<bool> failed{false};
+    std::mutex errorMutex;
+    std::exception_ptr error;
+
+    std::function<void(std::shared_ptr<Spliterator<T>>)> process;
+    process = [&](std::shared_ptr<Spliterator<T>> spliterator) {
+        try {
+            while (!failed.load(std::memory_order_relaxed) && spliterator->estimateSize() > LeafSize) {
+                std::shared_ptr<Spliterator<T>> prefix = spliterator->trySplit();
+                if (!prefix) break;
+                pending.fetch_add(1, std::memory_order_relaxed);
+                try {
+                    pool.submit([&process, prefix] { process(prefix); });
+                } catch (...) {
+                    pending.fetch_sub(1, std::memory_order_relaxed);
+                    throw;
+                }
+            }
+            if (!failed.load(std::memory_order_relaxed)) {
+                leaf(*spliterator);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+            failed.store(true, std::memory_order_relaxed);
+        }
+        pool.finish(pending);
+    };
+
+    std::shared_ptr<Spliterator<T>> shared(std::move(root));
+    pool.submit([&process, shared] { process(shared); });
+    pool.waitFor(pending);
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+}  // namespace parallel_detail
+
+template <typename T, typename Function>
+void parallelForEach(const Aggregate<T>& aggregate, Function function, WorkStealingPool& pool) {
+    auto leaf = [&function](Spliterator<T>& spliterator) {
+        for (auto chunk = spliterator.nextChunk(parallel_detail::ChunkSize); !chunk.empty();
+             chunk = spliterator.nextChunk(parallel_detail::ChunkSize)) {
+            for (const T& item : chunk) {
+                function(item);
+            }
+        }
+    };
+    parallel_detail::splitAndRun(pool, aggregate.createSpliterator(), leaf);
+}
+
+// accumulate(result, item) folds one element; combine(a, b) merges partials.
+// identity must be neutral for combine. Partials are combined in encounter
+// order once every piece has finished, so combine must be associative but
+// need not be commutative.
+template <typename T, typename R, typename Accumulate, typename Combine>
+R parallelReduce(const Aggregate<T>& aggregate, R identity, Accumulate accumulate, Combine combine,
+                 WorkStealingPool& pool) {
+    std::mutex partialsMutex;
+    std::vector<std::pair<size_t, R>> partials;  // Keyed by each piece's position()
+    auto leaf = [&](Spliterator<T>& spliterator) {
+        size_t position = spliterator.position();
+        R partial = identity;
+        for (auto chunk = spliterator.nextChunk(parallel_detail::ChunkSize); !chunk.empty();
+             chunk = spliterator.nextChunk(parallel_detail::ChunkSize)) {
+            for (const T& item : chunk) {
+                partial = accumulate(partial, item);
+            }
+        }
+        std::lock_guard<std::mutex> lock(partialsMutex);
+        partials.emplace_back(position, std::move(partial));
+    };
+    parallel_detail::splitAndRun(pool, aggregate.createSpliterator(), leaf);
+
+    std::sort(partials.begin(), partials.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    R result = identity;
+    for (auto& [position, partial] : partials) {
+        result = combine(result, partial);
+    }
+    return result;
+}
+
+// Results keep encounter order. Each piece writes straight into its slots, so
+// that needs a sized source such as VectorCollection; any other source is
+// collected serially on the calling thread.
+template <typename T, typename Function>
+auto parallelTransform(const Aggregate<T>& aggregate, Function function, WorkStealingPool& pool)
+    -> std::vector<std::invoke_result_t<Function, const T&>> {
+    auto spliterator = aggregate.createSpliterator();
+    std::vector<std::invoke_result_t<Function, const T&>> results;
+    if (!spliterator->isSized()) {
+        for (auto chunk = spliterator->nextChunk(parallel_detail::ChunkSize); !chunk.empty();
+             chunk = spliterator->nextChunk(parallel_detail::ChunkSize)) {
+            for (const T& item : chunk) {
+                results.push_back(function(item));
+            }
+        }
+        return results;
+    }
+    results.resize(spliterator->estimateSize());
+    auto leaf = [&](Spliterator<T>& piece) {
+        size_t index = piece.position();
+        for (auto chunk = piece.nextChunk(parallel_detail::ChunkSize); !chunk.empty();
+             chunk = piece.nextChunk(parallel_detail::ChunkSize)) {
+            for (const T& item : chunk) {
+                results[index++] = function(item);
+            }
+        }
+    };
+    parallel_detail::splitAndRun(pool, std::move(spliterator), leaf);
+    return results;
+}
+
+// Step 9: Lazy, fused adaptor pipelines
+// collection | map(f) | filter(p) | take(n) builds a nested view type; no
+// element is touched until the result is iterated, and then every stage runs
+// inside the same loop body with no virtual calls and no intermediate
+// vectors. Views expose begin()/end() of one iterator type, so they work with
+// range-for and <algorithm>. Sources are VectorCollection (a span over its
+// storage) or any Iterator<T> (pulled with nextChunk(), single pass only).
+struct ViewBase {};
+
+template <typename T>
+class SpanView : public ViewBase {
+private:
+    std::span<const T> items;
+
+public:
+    explicit SpanView(std::span<const T> items) : items(items) {}
+
+    const T* begin() const { return items.data(); }
+    const T* end() const { return items.data() + items.size(); }
+};
+
+template <typename T>
+class IteratorView : public ViewBase {
+private:
+    struct State {
+        std::unique_ptr<Iterator<T>> source;
+        std::span<const T> chunk;
+        size_t index = 0;
+
+        bool refill() {
+            chunk = source->nextChunk(4096);
+            index = 0;
+            return !chunk.empty();
+        }
+    };
+
+    std::shared_ptr<State> state;
+
+public:
+    class iterator {
+    private:
+        State* state = nullptr;  // nullptr once exhausted (equals end())
+
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using reference = const T&;
+        using pointer = const T*;
+
+        iterator() = default;
+        explicit iterator(State* state) : state(state) {
+            if (state->index >= state->chunk.size() && !state->refill()) {
+                this->state = nullptr;
+            }
+        }
+
+        const T& operator*() const { return state->chunk[state->index]; }
+
+        iterator& operator++() {
+            if (++state->index >= state->chunk.size() && !state->refill()) {
+                state = nullptr;
+            }
+            return *this;
+        }
+
+        void operator++(int) { ++*this; }
+
+        bool operator==(const iterator& other) const { return state == other.state; }
+    };
+
+    explicit IteratorView(std::unique_ptr<Iterator<T>> source)
+        : state(std::make_shared<State>(State{std::move(source), {}, 0})) {}
+
+    iterator begin() const { return iterator(state.get()); }
+    iterator end() const { return iterator(); }
+};
+
+template <typename V>
+using ViewIterator = decltype(std::declval<const V&>().begin());
+
+template <typename V>
+using ViewValue = std::remove_cvref_t<decltype(*std::declval<ViewIterator<V>>())>;
+
+// A view over an IteratorView can only be walked once, and its adaptors say so
+template <typename V>
+inline constexpr bool isSinglePass =
+    !std::is_base_of_v<std::forward_iterator_tag, typename std::iterator_traits<ViewIterator<V>>::iterator_category>;
+
+template <typename V>
+using ViewCategory = std::conditional_t<isSinglePass<V>, std::input_iterator_tag, std::forward_iterator_tag>;
+
+// Postfix ++ for adaptor iterators. A copy of a single-pass iterator shares
+// the state being advanced, so there it returns nothing, like IteratorView's.
+template <bool SinglePass, typename It>
+auto postIncrement(It& it) {
+    if constexpr (SinglePass) {
+        ++it;
+    } else {
+        It copy = it;
+        ++it;
+        return copy;
+    }
+}
+
+template <typename Base, typename F>
+class MapView : public ViewBase {
+private:
+    Base base;
+    F function;
+
+public:
+    class iterator {
+    private:
+        ViewIterator<Base> current;
+        const F* function = nullptr;
+
+    public:
+        using iterator_category = ViewCategory<Base>;
+        using value_type = std::remove_cvref_t<std::invoke_result_t<const F&, decltype(*current)>>;
+        using difference_type = std::ptrdiff_t;
+        using reference = value_type;
+        using pointer = void;
+
+        iterator() = default;
+        iterator(ViewIterator<Base> current, const F* function) : current(current), function(function) {}
+
+        value_type operator*() const { return (*function)(*current); }
+        iterator& operator++() { ++current; return *this; }
+        auto operator++(int) { return postIncrement<isSinglePass<Base>>(*this); }
+        bool operator==(const iterator& other) const { return current == other.current; }
+    };
+
+    MapView(Base base, F function) : base(std::move(base)), function(std::move(function)) {}
+
+    iterator begin() const { return iterator(base.begin(), &function); }
+    iterator end() const { return iterator(base.end(), &function); }
 };
 
-// Step 5: Use the Iterator pattern in client code
-int main() {
+template <typename Base, typename Predicate>
+class FilterView : public ViewBase {
+private:
+    Base base;
+    Predicate predicate;
+
+public:
+    class iterator {
+    private:
+        ViewIterator<Base> current;
+        ViewIterator<Base> last;
+        const Predicate* predicate = nullptr;
+
+        void skip() {
+            while (current != last && !(*predicate)(*current)) {
+                ++current;
+            }
+        }
+
+    public:
+        using iterator_category = ViewCategory<Base>;
+        using value_type = ViewValue<Base>;
+        using difference_type = std::ptrdiff_t;
+        using reference = decltype(*current);
+        using pointer = void;
+
+        iterator() = default;
+        iterator(ViewIterator<Base> current, ViewIterator<Base> last, const Predicate* predicate)
+            : current(current), last(last), predicate(predicate) {
+            skip();
+        }
+
+        reference operator*() const { return *current; }
+        iterator& operator++() { ++current; skip(); return *this; }
+        auto operator++(int) { return postIncrement<isSinglePass<Base>>(*this); }
+        bool operator==(const iterator& other) const { return current == other.current; }
+    };
+
+    FilterView(Base base, Predicate predicate) : base(std::move(base)), predicate(std::move(predicate)) {}
+
+    iterator begin() const { return iterator(base.begin(), base.end(), &predicate); }
+    iterator end() const { return iterator(base.end(), base.end(), &predicate); }
+};
+
+template <typename Base>
+class TakeView : public ViewBase {
+private:
+    Base base;
+    size_t count;
+
+public:
+    class iterator {
+    private:
+        ViewIterator<Base> current;
+        ViewIterator<Base> last;
+        size_t remaining = 0;
+
+        bool done() const { return remaining == 0 || current == last; }
+
+    public:
+        using iterator_category = ViewCategory<Base>;
+        using value_type = ViewValue<Base>;
+        using difference_type = std::ptrdiff_t;
+        using reference = decltype(*current);
+        using pointer = void;
+
+        iterator() = default;
+        iterator(ViewIterator<Base> current, ViewIterator<Base> last, size_t remaining)
+            : current(current), last(last), remaining(remaining) {}
+
+        reference operator*() const { return *current; }
+        iterator& operator++() { ++current; --remaining; return *this; }
+        auto operator++(int) { return postIncrement<isSinglePass<Base>>(*this); }
+
+        bool operator==(const iterator& other) const {
+            if (done() || other.done()) return done() == other.done();
+            return current == other.current;
+        }
+    };
+
+    TakeView(Base base, size_t count) : base(std::move(base)), count(count) {}
+
+    iterator begin() const { return iterator(base.begin(), base.end(), count); }
+    iterator end() const { return iterator(base.end(), base.end(), 0); }
+};
+
+template <typename Left, typename Right>
+class ZipView : public ViewBase {
+private:
+    Left left;
+    Right right;
+
+public:
+    class iterator {
+    private:
+        ViewIterator<Left> leftCurrent, leftLast;
+        ViewIterator<Right> rightCurrent, rightLast;
+
+        bool done() const { return leftCurrent == leftLast || rightCurrent == rightLast; }
+
+    public:
+        using iterator_category =
+            std::conditional_t<isSinglePass<Left> || isSinglePass<Right>, std::input_iterator_tag,
+                               std::forward_iterator_tag>;
+        using value_type = std::pair<ViewValue<Left>, ViewValue<Right>>;
+        using difference_type = std::ptrdiff_t;
+        using reference = value_type;
+        using pointer = void;
+
+        iterator() = default;
+        iterator(ViewIterator<Left> leftCurrent, ViewIterator<Left> leftLast,
+                 ViewIterator<Right> rightCurrent, ViewIterator<Right> rightLast)
+            : leftCurrent(leftCurrent), leftLast(leftLast), rightCurrent(rightCurrent), rightLast(rightLast) {}
+
+        value_type operator*() const { return {*leftCurrent, *rightCurrent}; }
+        iterator& operator++() { ++leftCurrent; ++rightCurrent; return *this; }
+        auto operator++(int) { return postIncrement<isSinglePass<Left> || isSinglePass<Right>>(*this); }
+
+        bool operator==(const iterator& other) const {
+            if (done() || other.done()) return done() == other.done();
+            return leftCurrent == other.leftCurrent && rightCurrent == other.rightCurrent;
+        }
+    };
+
+    ZipView(Left left, Right right) : left(std::move(left)), right(std::move(right)) {}
+
+    iterator begin() const { return iterator(left.begin(), left.end(), right.begin(), right.end()); }
+    iterator end() const { return iterator(left.end(), left.end(), right.end(), right.end()); }
+};
+
+// Each element is itself a view of up to `size` consecutive elements. Over a
+// multi-pass base a chunk is a pair of positions into it; a single-pass base
+// cannot be read twice, so each chunk is copied out in one pass into a buffer
+// that stays valid until the iterator advances.
+template <typename Base>
+class ChunkView : public ViewBase {
+private:
+    Base base;
+    size_t size;
+
+    static constexpr bool buffered = isSinglePass<Base>;
+
+public:
+    class Chunk {
+    private:
+        ViewIterator<Base> first, last;
+        size_t count;
+
+    public:
+        Chunk(ViewIterator<Base> first, ViewIterator<Base> last, size_t count)
+            : first(first), last(last), count(count) {}
+
+        typename TakeView<Base>::iterator begin() const { return {first, last, count}; }
+        typename TakeView<Base>::iterator end() const { return {last, last, 0}; }
+    };
+
+    using BufferedChunk = SpanView<ViewValue<Base>>;
+
+    class iterator {
+    private:
+        ViewIterator<Base> current, last;
+        size_t size = 0;
+        std::shared_ptr<std::vector<ViewValue<Base>>> buffer;  // Single-pass bases only
+
+        void fill() {
+            buffer->clear();
+            for (size_t i = 0; i < size && current != last; ++i, ++current) {
+                buffer->push_back(*current);
+            }
+        }
+
+        bool exhausted() const { return !buffer || buffer->empty(); }
+
+    public:
+        using iterator_category = ViewCategory<Base>;
+        using value_type = std::conditional_t<buffered, BufferedChunk, Chunk>;
+        using difference_type = std::ptrdiff_t;
+        using reference = value_type;
+        using pointer = void;
+
+        iterator() = default;
+        iterator(ViewIterator<Base> current, ViewIterator<Base> last, size_t size)
+            : current(current), last(last), size(size) {
+            if constexpr (buffered) {
+                if (this->current != this->last) {
+                    buffer = std::make_shared<std::vector<ViewValue<Base>>>();
+                    buffer->reserve(size);
+                    fill();
+                }
+            }
+        }
+
+        value_type operator*() const {
+            if constexpr (buffered) {
+                return BufferedChunk(*buffer);
+            } else {
+                return Chunk(current, last, size);
+            }
+        }
+
+        iterator& operator++() {
+            if constexpr (buffered) {
+                fill();
+            } else {
+                for (size_t i = 0; i < size && current != last; ++i) {
+                    ++current;
+                }
+            }
+            return *this;
+        }
+
+        auto operator++(int) { return postIncrement<buffered>(*this); }
+
+        bool operator==(const iterator& other) const {
+            if constexpr (buffered) {
+                return exhausted() && other.exhausted();
+            } else {
+                return current == other.current;
+            }
+        }
+    };
+
+    ChunkView(Base base, size_t size) : base(std::move(base)), size(size == 0 ? 1 : size) {}
+
+    iterator begin() const { return iterator(base.begin(), base.end(), size); }
+    iterator end() const { return iterator(base.end(), base.end(), size); }
+};
+
+// Turning sources into views
+template <typename T>
+SpanView<T> toView(const VectorCollection<T>& collection) {
+    return SpanView<T>(collection.view());
+}
+
+template <typename T>
+SpanView<T> toView(const MappedFileCollection<T>& collection) {
+    return SpanView<T>(collection.view());
+}
+
+// A view only borrows the collection, so a temporary one would dangle
+template <typename T>
+SpanView<T> toView(const VectorCollection<T>&&) = delete;
+
+template <typename T>
+SpanView<T> toView(const MappedFileCollection<T>&&) = delete;
+
+template <typename T>
+IteratorView<T> toView(std::unique_ptr<Iterator<T>> iterator) {
+    return IteratorView<T>(std::move(iterator));
+}
+
+template <typename V, typename = std::enable_if_t<std::is_base_of_v<ViewBase, std::decay_t<V>>>>
+std::decay_t<V> toView(V&& view) {
+    return std::forward<V>(view);
+}
+
+template <typename V>
+using ViewOf = decltype(toView(std::declval<V>()));
+
+// Adaptor objects applied with operator|
+template <typename F> struct MapAdaptor { F function; };
+template <typename P> struct FilterAdaptor { P predicate; };
+struct TakeAdaptor { size_t count; };
+struct ChunkAdaptor { size_t size; };
+
+template <typename F> MapAdaptor<F> map(F function) { return {std::move(function)}; }
+template <typename P> FilterAdaptor<P> filter(P predicate) { return {std::move(predicate)}; }
+inline TakeAdaptor take(size_t count) { return {count}; }
+inline ChunkAdaptor chunk(size_t size) { return {size}; }
+
+template <typename Source, typename F>
+MapView<ViewOf<Source>, F> operator|(Source&& source, MapAdaptor<F> adaptor) {
+    return {toView(std::forward<Source>(source)), std::move(adaptor.function)};
+}
+
+template <typename Source, typename P>
+FilterView<ViewOf<Source>, P> operator|(Source&& source, FilterAdaptor<P> adaptor) {
+    return {toView(std::forward<Source>(source)), std::move(adaptor.predicate)};
+}
+
+template <typename Source>
+TakeView<ViewOf<Source>> operator|(Source&& source, TakeAdaptor adaptor) {
+    return {toView(std::forward<Source>(source)), adaptor.count};
+}
+
+template <typename Source>
+ChunkView<ViewOf<Source>> operator|(Source&& source, ChunkAdaptor adaptor) {
+    return {toView(std::forward<Source>(source)), adaptor.size};
+}
+
+template <typename Left, typename Right>
+ZipView<ViewOf<Left>, ViewOf<Right>> zip(Left&& left, Right&& right) {
+    return {toView(std::forward<Left>(left)), toView(std::forward<Right>(right))};
+}
+
+// Step 10: Benchmarks
+// 10a: Per-element against batched iteration
+void benchmarkBatchedIteration(size_t count) {
+    VectorCollection<int> numbers;
+    numbers.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        numbers.add(static_cast<int>(i & 0xFFFF));
+    }
+
+    auto time = [](const char* label, size_t count, auto&& body) {
+        auto start = std::chrono::steady_clock::now();
+        int64_t sum = body();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << label << ": " << seconds * 1e3 << " ms (" << count / seconds / 1e6
+                  << " M elements/s, sum " << sum << ")" << std::endl;
+    };
+
+    time("hasNext()/next()", count, [&] {
+        int64_t sum = 0;
+        auto iterator = numbers.createIterator();
+        while (iterator->hasNext()) {
+            sum += iterator->next();
+        }
+        return sum;
+    });
+
+    time("nextBatch(4096)", count, [&] {
+        int64_t sum = 0;
+        auto iterator = numbers.createIterator();
+        std::vector<int> batch(4096);
+        while (size_t filled = iterator->nextBatch(batch)) {
+            for (size_t i = 0; i < filled; ++i) {
+                sum += batch[i];
+            }
+        }
+        return sum;
+    });
+
+    time("nextChunk(4096)", count, [&] {
+        int64_t sum = 0;
+        auto iterator = numbers.createIterator();
+        for (auto chunk = iterator->nextChunk(4096); !chunk.empty(); chunk = iterator->nextChunk(4096)) {
+            for (int value : chunk) {
+                sum += value;
+            }
+        }
+        return sum;
+    });
+}
+
+// 10b: Parallel reduction scaling with thread count
+void benchmarkParallelReduce(size_t count) {
+    VectorCollection<int> numbers;
+    numbers.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        numbers.add(static_cast<int>(i % 1000));
+    }
+    auto sumOfSquares = [](int64_t total, int value) { return total + int64_t(value) * value; };
+    auto plus = [](int64_t a, int64_t b) { return a + b; };
+
+    auto start = std::chrono::steady_clock::now();
+    int64_t serial = 0;
+    auto iterator = numbers.createIterator();
+    while (iterator->hasNext()) {
+        serial = sumOfSquares(serial, iterator->next());
+    }
+    double serialSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "\nSerial createIterator() reduce: " << serialSeconds * 1e3 << " ms" << std::endl;
+
+    size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<size_t> threadCounts;
+    for (size_t threads = 1; threads < cores; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(cores);
+
+    for (size_t threads : threadCounts) {
+        WorkStealingPool pool(threads);
+        start = std::chrono::steady_clock::now();
+        int64_t parallel = parallelReduce(numbers, int64_t(0), sumOfSquares, plus, pool);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << threads << " thread(s): " << seconds * 1e3 << " ms (" << serialSeconds / seconds
+                  << "x vs serial)" << (parallel == serial ? "" : " MISMATCH") << std::endl;
+    }
+}
+
+// 10c: Materialized stages against a fused pipeline
+void benchmarkFusedPipeline(size_t count) {
+    VectorCollection<int> numbers;
+    numbers.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        numbers.add(static_cast<int>(i % 1000));
+    }
+    size_t limit = count / 2;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<int> tripled, evens, shifted;
+    auto iterator = numbers.createIterator();
+    while (iterator->hasNext()) {
+        tripled.push_back(iterator->next() * 3);
+    }
+    for (int value : tripled) {
+        if (value % 2 == 0) evens.push_back(value);
+    }
+    for (size_t i = 0; i < evens.size() && i < limit; ++i) {
+        shifted.push_back(evens[i] + 1);
+    }
+    int64_t materializedSum = std::accumulate(shifted.begin(), shifted.end(), int64_t(0));
+    double materializedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    auto pipeline = numbers
+        | map([](int value) { return value * 3; })
+        | filter([](int value) { return value % 2 == 0; })
+        | take(limit)
+        | map([](int value) { return value + 1; });
+    int64_t fusedSum = std::accumulate(pipeline.begin(), pipeline.end(), int64_t(0));
+    double fusedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "\nMaterialized stages: " << materializedSeconds * 1e3 << " ms" << std::endl;
+    std::cout << "Fused pipeline:      " << fusedSeconds * 1e3 << " ms (" << materializedSeconds / fusedSeconds
+              << "x)" << (fusedSum == materializedSum ? "" : " MISMATCH") << std::endl;
+}
+
+// 10d: Scan throughput of a memory-mapped file on a cold and a warm page cache
+// The cold runs evict the file with posix_fadvise() first. That is only a
+// hint, so on some filesystems a "cold" run is partly warm.
+void benchmarkMappedScan(size_t count) {
+    // mkstemp() creates a fresh owner-only file, never one planted at the path
+    std::string path = (std::filesystem::temp_directory_path() / "iterator_mapped_bench.XXXXXX").string();
+    int fd = mkostemp(path.data(), O_CLOEXEC);
+    if (fd < 0) {
+        std::cout << "\nMapped scan skipped: cannot create " << path << std::endl;
+        return;
+    }
+    std::vector<uint64_t> block(1 << 16);
+    for (size_t written = 0; written < count;) {
+        size_t filled = std::min(block.size(), count - written);
+        std::iota(block.begin(), block.begin() + filled, uint64_t(written));
+        if (write(fd, block.data(), filled * sizeof(uint64_t)) != ssize_t(filled * sizeof(uint64_t))) {
+            std::cout << "\nMapped scan skipped: short write to " << path << std::endl;
+            close(fd);
+            std::remove(path.c_str());
+            return;
+        }
+        written += filled;
+    }
+    fdatasync(fd);  // Dirty pages cannot be evicted
+    close(fd);
+
+    uint64_t expected = uint64_t(count) * (count - 1) / 2;
+    double gigabytes = count * sizeof(uint64_t) / 1e9;
+    std::cout << "\nMapped file of " << gigabytes << " GB:" << std::endl;
+
+    auto scan = [&](const char* label, size_t readAheadBytes, bool cold) {
+        if (cold) {
+            int evictFd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            posix_fadvise(evictFd, 0, 0, POSIX_FADV_DONTNEED);
+            close(evictFd);
+        }
+        auto start = std::chrono::steady_clock::now();
+        MappedFileCollection<uint64_t> records(path, readAheadBytes);
+        double openSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        uint64_t sum = 0;
+        auto iterator = records.createIterator();
+        for (auto chunk = iterator->nextChunk(4096); !chunk.empty(); chunk = iterator->nextChunk(4096)) {
+            for (uint64_t value : chunk) {
+                sum += value;
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << label << ": " << seconds * 1e3 << " ms (" << gigabytes / seconds << " GB/s, open "
+                  << openSeconds * 1e6 << " us)" << (sum == expected ? "" : " MISMATCH") << std::endl;
+    };
+
+    scan("Cold, no read-ahead hints", 0, true);
+    scan("Cold, 8 MB read-ahead    ", 8 << 20, true);
+    scan("Warm, no read-ahead hints", 0, false);
+    scan("Warm, 8 MB read-ahead    ", 8 << 20, false);
+    std::remove(path.c_str());
+}
+
+// Step 11: Use the Iterator pattern in client code
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        size_t count = argc > 2 ? std::stoul(argv[2]) : 100000000;
+        benchmarkBatchedIteration(count);
+        benchmarkParallelReduce(count);
+        benchmarkFusedPipeline(count);
+        benchmarkMappedScan(count);
+        return 0;
+    }
+
     VectorCollection<int> numbers;
     numbers.add(10);
     numbers.add(20);
@@ -70,5 +1336,72 @@ int main() {
         std::cout << "Next item: " << iterator->next() << std::endl;
     }
 
+    // Pull elements in chunks instead: one virtual call per chunk
+    auto chunked = numbers.createIterator();
+    for (auto chunk = chunked->nextChunk(2); !chunk.empty(); chunk = chunked->nextChunk(2)) {
+        std::cout << "Chunk of " << chunk.size() << ":";
+        for (int value : chunk) {
+            std::cout << " " << value;
+        }
+        std::cout << std::endl;
+    }
+
+    // Split the collection across a work-stealing pool
+    WorkStealingPool pool(2);
+    int total = parallelReduce(numbers, 0, [](int sum, int value) { return sum + value; },
+                               [](int a, int b) { return a + b; }, pool);
+    std::cout << "Parallel sum: " << total << std::endl;  // Output: 60
+
+    auto doubled = parallelTransform(numbers, [](int value) { return value * 2; }, pool);
+    std::cout << "Parallel transform:";
+    for (int value : doubled) {
+        std::cout << " " << value;  // Output: 20 40 60
+    }
+    std::cout << std::endl;
+
+    std::atomic<int> visited{0};
+    parallelForEach(numbers, [&visited](int) { visited.fetch_add(1); }, pool);
+    std::cout << "Parallel forEach visited " << visited << " items" << std::endl;  // Output: 3
+
+    // Lazy adaptors fuse into one loop and work with range-for and <algorithm>
+    std::cout << "Squares of items above 10:";
+    for (int value : numbers | filter([](int n) { return n > 10; }) | map([](int n) { return n * n; })) {
+        std::cout << " " << value;  // Output: 400 900
+    }
+    std::cout << std::endl;
+
+    auto labels = VectorCollection<int>();
+    labels.add(1);
+    labels.add(2);
+    for (auto [number, label] : zip(numbers, labels)) {
+        std::cout << "Pair: " << number << ", " << label << std::endl;  // Output: 10, 1 then 20, 2
+    }
+
+    for (auto group : numbers | chunk(2)) {
+        std::cout << "Group size: " << std::distance(group.begin(), group.end()) << std::endl;  // Output: 2 then 1
+    }
+
+    auto pulled = numbers.createIterator() | take(2);
+    std::cout << "From an Iterator<T>: " << std::accumulate(pulled.begin(), pulled.end(), 0) << std::endl;  // Output: 30
+
+    // A file of records iterates through the same interface without loading it
+    std::string path = (std::filesystem::temp_directory_path() / "iterator_demo.XXXXXX").string();
+    int fd = mkostemp(path.data(), O_CLOEXEC);
+    if (FILE* file = fd >= 0 ? fdopen(fd, "wb") : nullptr) {
+        auto values = numbers.view();
+        std::fwrite(values.data(), sizeof(int), values.size(), file);
+        std::fclose(file);
+        MappedFileCollection<int> records(path);
+        auto mapped = records.createIterator();
+        while (mapped->hasNext()) {
+            std::cout << "Mapped item: " << mapped->next() << std::endl;  // Output: 10, 20, 30
+        }
+        std::cout << "Mapped sum above 15: "
+                  << parallelReduce(records, 0, [](int sum, int value) { return value > 15 ? sum + value : sum; },
+                                    [](int a, int b) { return a + b; }, pool)
+                  << std::endl;  // Output: 50
+        std::remove(path.c_str());
+    }
+
     return 0;
 }
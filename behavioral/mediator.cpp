@@ -1,17 +1,125 @@
-
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 #include <vector>
-#include <memory>
 
-// Step 1: Define the Mediator interface
+#include <arpa/inet.h>
+#include <endian.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "allocation_counter.h"
+
+// Step 1: Define an immutable, reference-counted message
+// A broadcast formats "sender: text" once, into a single heap block that holds
+// the reference count and the characters. Copies share the block, so
+// delivering to N users costs N reference-count updates instead of N strings.
+class Message {
+private:
+    struct Block {
+        std::atomic<size_t> references;
+        size_t length;
+        size_t senderLength;
+
+        char* text() {
+            return reinterpret_cast<char*>(this + 1);
+        }
+    };
+
+    Block* block = nullptr;
+
+    void release() {
+        if (block && block->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            block->~Block();
+            ::operator delete(block);
+        }
+    }
+
+public:
+    Message() = default;
+
+    Message(std::string_view sender, std::string_view body) {
+        size_t length = sender.size() + 2 + body.size();
+        block = new (::operator new(sizeof(Block) + length)) Block{{1}, length, sender.size()};
+        char* out = block->text();
+        std::memcpy(out, sender.data(), sender.size());
+        std::memcpy(out + sender.size(), ": ", 2);
+        std::memcpy(out + sender.size() + 2, body.data(), body.size());
+    }
+
+    Message(const Message& other) : block(other.block) {
+        if (block) {
+            block->references.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    Message(Message&& other) noexcept : block(other.block) {
+        other.block = nullptr;
+    }
+
+    Message& operator=(Message other) noexcept {
+        std::swap(block, other.block);
+        return *this;
+    }
+
+    ~Message() {
+        release();
+    }
+
+    // The full "sender: body" text
+    std::string_view text() const {
+        return block ? std::string_view(block->text(), block->length) : std::string_view();
+    }
+
+    std::string_view sender() const {
+        return text().substr(0, block ? block->senderLength : 0);
+    }
+
+    std::string_view body() const {
+        return block ? text().substr(block->senderLength + 2) : std::string_view();
+    }
+
+    size_t useCount() const {
+        return block ? block->references.load(std::memory_order_relaxed) : 0;
+    }
+};
+
+// Step 2: Define the Mediator interface
 class ChatMediator {
 public:
     virtual ~ChatMediator() = default;
     virtual void sendMessage(const std::string& message, class User* user) = 0;
 };
 
-// Step 2: Define the User (Colleague) class
+// Step 3: Define the User (Colleague) class
 class User {
 protected:
     ChatMediator& mediator;
@@ -22,8 +130,9 @@ public:
 
     virtual ~User() = default;
 
-    virtual void receiveMessage(const std::string& message) const {
-        std::cout << name << " received: " << message << std::endl;
+    // The message is shared with the other recipients; copy it to keep it
+    virtual void receiveMessage(const Message& message) const {
+        std::cout << name << " received: " << message.text() << std::endl;
     }
 
     virtual void sendMessage(const std::string& message) {
@@ -31,12 +140,12 @@ public:
         mediator.sendMessage(message, this);
     }
 
-    std::string getName() const {
+    const std::string& getName() const {
         return name;
     }
 };
 
-// Step 3: Create the Concrete Mediator (ChatRoom)
+// Step 4: Create the Concrete Mediator (ChatRoom)
 class ChatRoom : public ChatMediator {
 private:
     std::vector<User*> users;
@@ -46,17 +155,1515 @@ public:
         users.push_back(user);
     }
 
+    // Order of the remaining users is not preserved
+    void removeUser(User* user) {
+        auto found = std::find(users.begin(), users.end(), user);
+        if (found != users.end()) {
+            *found = users.back();
+            users.pop_back();
+        }
+    }
+
     void sendMessage(const std::string& message, User* sender) override {
+        Message shared(sender->getName(), message);  // Built once for every recipient
         for (auto* user : users) {
             if (user != sender) {  // Don't send the message to the sender
-                user->receiveMessage(sender->getName() + ": " + message);
+                user->receiveMessage(shared);
+            }
+        }
+    }
+};
+
+// Step 5: Deliver asynchronously through per-user mailboxes
+// A bounded multi-producer, single-consumer ring (Vyukov's sequence-number
+// design): producers claim a slot with one CAS on the tail, and the slot's
+// sequence number tells the consumer when the write has landed.
+template <typename T>
+class MpscMailbox {
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    size_t mask;
+    alignas(64) std::atomic<size_t> tail{0};
+    alignas(64) size_t head = 0;  // Only the consumer touches head
+
+public:
+    // Bumped by the consumer after freeing slots; blocked producers wait on it
+    std::atomic<uint32_t> drained{0};
+    // Set while the mailbox sits in a worker's ready queue
+    std::atomic<bool> scheduled{false};
+
+    // capacity is rounded up to a power of two
+    explicit MpscMailbox(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        slots = std::make_unique<Slot[]>(size);
+        mask = size - 1;
+        for (size_t i = 0; i < size; ++i) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool tryPush(const T& value) {
+        size_t position = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots[position & mask];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            auto lag = static_cast<std::ptrdiff_t>(sequence - position);
+            if (lag == 0) {
+                if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    slot.value = value;
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (lag < 0) {
+                return false;  // Full: the consumer has not freed this slot yet
+            } else {
+                position = tail.load(std::memory_order_relaxed);
             }
         }
     }
+
+    bool tryPop(T& out) {
+        Slot& slot = slots[head & mask];
+        if (slot.sequence.load(std::memory_order_seq_cst) != head + 1) {
+            return false;
+        }
+        out = std::move(slot.value);
+        slot.sequence.store(head + mask + 1, std::memory_order_release);
+        ++head;
+        return true;
+    }
+
+    bool empty() const {
+        return slots[head & mask].sequence.load(std::memory_order_seq_cst) != head + 1;
+    }
 };
 
-// Step 4: Use the Mediator pattern in the client code
-int main() {
+// Log-linear latency histogram: 16 linear steps per power of two, so each
+// bucket is within about 6% of the values it holds
+class LatencyHistogram {
+private:
+    static constexpr int SubBits = 4;
+    std::vector<std::atomic<uint64_t>> buckets = std::vector<std::atomic<uint64_t>>(64 << SubBits);
+
+    static size_t bucketOf(uint64_t nanoseconds) {
+        if (nanoseconds < (1u << SubBits)) {
+            return nanoseconds;
+        }
+        int shift = 63 - __builtin_clzll(nanoseconds) - SubBits;
+        return ((shift + 1) << SubBits) + ((nanoseconds >> shift) & ((1u << SubBits) - 1));
+    }
+
+    static uint64_t lowerBound(size_t bucket) {
+        size_t group = bucket >> SubBits;
+        uint64_t step = bucket & ((1u << SubBits) - 1);
+        return group == 0 ? step : ((1u << SubBits) + step) << (group - 1);
+    }
+
+public:
+    void record(uint64_t nanoseconds) {
+        buckets[bucketOf(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void mergeInto(std::vector<uint64_t>& totals) const {
+        totals.resize(buckets.size());
+        for (size_t i = 0; i < buckets.size(); ++i) {
+            totals[i] += buckets[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    static uint64_t percentile(const std::vector<uint64_t>& totals, double fraction) {
+        uint64_t count = 0;
+        for (uint64_t n : totals) {
+            count += n;
+        }
+        uint64_t rank = static_cast<uint64_t>(fraction * count);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < totals.size(); ++i) {
+            seen += totals[i];
+            if (seen > rank) {
+                return lowerBound(i);
+            }
+        }
+        return 0;
+    }
+};
+
+enum class OverflowPolicy { Drop, Block };
+
+struct DeliveryStats {
+    uint64_t delivered = 0;
+    uint64_t dropped = 0;
+    uint64_t p50Nanoseconds = 0;
+    uint64_t p99Nanoseconds = 0;
+    uint64_t p999Nanoseconds = 0;
+};
+
+// Each user owns a bounded mailbox, and each mailbox belongs to one worker,
+// so a user's messages are delivered in order and never concurrently. A
+// producer that makes a mailbox non-empty schedules it on its worker; the
+// worker drains up to batchSize messages per visit. A slow receiveMessage
+// only delays its own worker instead of the sender.
+//
+// When a mailbox is full, Drop discards the message for that user and Block
+// waits for room. Sends made from inside receiveMessage always drop on
+// overflow, since blocking a delivery thread can deadlock the room.
+// Add all users before the first send.
+class AsyncChatRoom : public ChatMediator {
+private:
+    struct Delivery {
+        Message message;
+        int64_t sentAt = 0;  // steady_clock nanoseconds
+    };
+
+    struct Recipient {
+        User* user;
+        MpscMailbox<Delivery> mailbox;
+        size_t worker;
+
+        Recipient(User* user, size_t capacity, size_t worker) : user(user), mailbox(capacity), worker(worker) {}
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::condition_variable ready;
+        std::deque<Recipient*> queue;
+        LatencyHistogram latency;
+        std::atomic<uint64_t> delivered{0};
+        std::thread thread;
+    };
+
+    size_t mailboxCapacity;
+    OverflowPolicy policy;
+    size_t batchSize;
+    std::vector<std::unique_ptr<Recipient>> recipients;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<size_t> pending{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<bool> stopping{false};
+
+    static inline thread_local bool onDeliveryThread = false;
+
+    static int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    void enqueueReady(Worker& worker, const std::vector<Recipient*>& batch) {
+        {
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            worker.queue.insert(worker.queue.end(), batch.begin(), batch.end());
+        }
+        worker.ready.notify_one();
+    }
+
+    void runWorker(Worker& worker) {
+        onDeliveryThread = true;
+        std::vector<Recipient*> requeue;
+        for (;;) {
+            Recipient* recipient;
+            {
+                std::unique_lock<std::mutex> lock(worker.mutex);
+                worker.ready.wait(lock, [&] { return stopping || !worker.queue.empty(); });
+                if (worker.queue.empty()) {
+                    return;
+                }
+                recipient = worker.queue.front();
+                worker.queue.pop_front();
+            }
+
+            Delivery delivery;
+            size_t count = 0;
+            while (count < batchSize && recipient->mailbox.tryPop(delivery)) {
+                recipient->user->receiveMessage(delivery.message);
+                worker.latency.record(static_cast<uint64_t>(now() - delivery.sentAt));
+                delivery.message = Message();
+                ++count;
+            }
+            recipient->mailbox.drained.fetch_add(1, std::memory_order_release);
+            recipient->mailbox.drained.notify_all();
+            worker.delivered.fetch_add(count, std::memory_order_relaxed);
+
+            // Clear the flag before re-checking, so a push racing with the
+            // clear either sees it cleared or is seen here
+            if (count == batchSize) {
+                requeue.assign(1, recipient);  // Still busy: go to the back of the line
+                enqueueReady(worker, requeue);
+            } else {
+                recipient->mailbox.scheduled.store(false, std::memory_order_seq_cst);
+                if (!recipient->mailbox.empty() && !recipient->mailbox.scheduled.exchange(true)) {
+                    requeue.assign(1, recipient);
+                    enqueueReady(worker, requeue);
+                }
+            }
+
+            if (pending.fetch_sub(count, std::memory_order_acq_rel) == count) {
+                pending.notify_all();
+            }
+        }
+    }
+
+public:
+    explicit AsyncChatRoom(size_t workerCount = std::max(1u, std::thread::hardware_concurrency()),
+                           size_t mailboxCapacity = 64, OverflowPolicy policy = OverflowPolicy::Block,
+                           size_t batchSize = 32)
+        : mailboxCapacity(mailboxCapacity), policy(policy), batchSize(std::max<size_t>(1, batchSize)) {
+        for (size_t i = 0; i < std::max<size_t>(1, workerCount); ++i) {
+            workers.push_back(std::make_unique<Worker>());
+        }
+        for (auto& worker : workers) {
+            worker->thread = std::thread(&AsyncChatRoom::runWorker, this, std::ref(*worker));
+        }
+    }
+
+    ~AsyncChatRoom() override {
+        flush();
+        stopping = true;
+        for (auto& worker : workers) {
+            {
+                std::lock_guard<std::mutex> lock(worker->mutex);
+            }
+            worker->ready.notify_all();
+            worker->thread.join();
+        }
+    }
+
+    void addUser(User* user) {
+        size_t worker = recipients.size() % workers.size();
+        recipients.push_back(std::make_unique<Recipient>(user, mailboxCapacity, worker));
+    }
+
+    void sendMessage(const std::string& message, User* sender) override {
+        Delivery delivery{Message(sender->getName(), message), now()};
+        bool mayBlock = policy == OverflowPolicy::Block && !onDeliveryThread;
+
+        // Mailboxes this send made non-empty, handed to each worker in one lock
+        static thread_local std::vector<std::vector<Recipient*>> newlyReady;
+        newlyReady.resize(workers.size());
+        auto publishReady = [&] {
+            for (size_t w = 0; w < workers.size(); ++w) {
+                if (!newlyReady[w].empty()) {
+                    enqueueReady(*workers[w], newlyReady[w]);
+                    newlyReady[w].clear();
+                }
+            }
+        };
+
+        // Count the deliveries up front so pending never dips below zero
+        pending.fetch_add(recipients.size(), std::memory_order_relaxed);
+        size_t notQueued = 0;
+        uint64_t droppedHere = 0;
+        for (auto& recipient : recipients) {
+            if (recipient->user == sender) {  // Don't send the message to the sender
+                ++notQueued;
+                continue;
+            }
+            MpscMailbox<Delivery>& mailbox = recipient->mailbox;
+            bool pushed;
+            for (;;) {
+                uint32_t seen = mailbox.drained.load(std::memory_order_acquire);
+                if ((pushed = mailbox.tryPush(delivery)) || !mayBlock) {
+                    break;
+                }
+                publishReady();  // The worker we wait on may not know about its work yet
+                mailbox.drained.wait(seen, std::memory_order_acquire);
+            }
+            if (!pushed) {
+                ++notQueued;
+                ++droppedHere;
+            } else if (!mailbox.scheduled.exchange(true, std::memory_order_seq_cst)) {
+                newlyReady[recipient->worker].push_back(recipient.get());
+            }
+        }
+        publishReady();
+
+        dropped.fetch_add(droppedHere, std::memory_order_relaxed);
+        if (notQueued > 0 && pending.fetch_sub(notQueued, std::memory_order_acq_rel) == notQueued) {
+            pending.notify_all();
+        }
+    }
+
+    // Wait until every queued message has been delivered. Call it from
+    // outside receiveMessage.
+    void flush() {
+        for (size_t count = pending.load(std::memory_order_acquire); count != 0;
+             count = pending.load(std::memory_order_acquire)) {
+            pending.wait(count, std::memory_order_acquire);
+        }
+    }
+
+    DeliveryStats stats() const {
+        DeliveryStats result;
+        std::vector<uint64_t> totals;
+        for (auto& worker : workers) {
+            worker->latency.mergeInto(totals);
+            result.delivered += worker->delivered.load(std::memory_order_relaxed);
+        }
+        result.dropped = dropped.load(std::memory_order_relaxed);
+        result.p50Nanoseconds = LatencyHistogram::percentile(totals, 0.50);
+        result.p99Nanoseconds = LatencyHistogram::percentile(totals, 0.99);
+        result.p999Nanoseconds = LatencyHistogram::percentile(totals, 0.999);
+        return result;
+    }
+};
+
+// Step 6: Shard many rooms across independently locked shards
+// join() returns a Membership handle; leave() and broadcast() take it back.
+struct Membership {
+    uint32_t room = 0;
+    uint32_t slot = 0;
+    uint32_t generation = 0;
+};
+
+// Rooms are spread over shards, each behind its own lock, so broadcasts in
+// rooms on different shards never contend. A room keeps its members packed
+// in a dense vector for the broadcast loop. Each membership also owns a
+// stable slot that maps to its dense position, which makes join and leave
+// O(1): leave moves the last member into the hole. A slot's generation
+// changes when it is freed, so a stale handle is rejected rather than
+// aliasing the next member to reuse the slot.
+//
+// A broadcast copies the recipients out under the shard lock and delivers
+// after releasing it, so receiveMessage may join, leave or send freely.
+// Each broadcast takes a ticket from its shard, and leave() waits until every
+// broadcast ticketed before the removal has finished delivering, so a User
+// may be destroyed once leave() has returned for each of its memberships.
+// The exception is leave() called from inside receiveMessage: waiting there
+// could deadlock against the caller's own delivery, so it returns at once and
+// the user must outlive the delivery in progress.
+class ShardedChatMediator : public ChatMediator {
+private:
+    struct Room {
+        std::vector<User*> members;
+        std::vector<uint32_t> memberSlots;    // Dense position -> slot
+        std::vector<uint32_t> slotPositions;  // Slot -> dense position
+        std::vector<uint32_t> slotGenerations;
+        std::vector<uint32_t> freeSlots;
+
+        bool holds(const Membership& membership) const {
+            return membership.slot < slotGenerations.size() &&
+                   slotGenerations[membership.slot] == membership.generation;
+        }
+    };
+
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::vector<Room> rooms;
+        uint64_t nextTicket = 0;
+        std::vector<uint64_t> inFlight;  // Tickets of broadcasts still delivering
+        size_t waiters = 0;
+        std::condition_variable delivered;
+    };
+
+    // Marks a broadcast finished when delivery ends, even by an exception
+    class Delivery {
+    private:
+        Shard& shard;
+        uint64_t ticket;
+
+    public:
+        Delivery(Shard& shard, uint64_t ticket) : shard(shard), ticket(ticket) {
+            ++deliveryDepth;
+        }
+
+        ~Delivery() {
+            --deliveryDepth;
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto& inFlight = shard.inFlight;
+            *std::find(inFlight.begin(), inFlight.end(), ticket) = inFlight.back();
+            inFlight.pop_back();
+            if (shard.waiters > 0) {
+                shard.delivered.notify_all();
+            }
+        }
+    };
+
+    static inline thread_local size_t deliveryDepth = 0;
+
+    // Which rooms each user has joined, for ChatMediator::sendMessage. Striped
+    // by user so it does not become the one structure everyone locks.
+    struct alignas(64) UserStripe {
+        std::mutex mutex;
+        std::unordered_map<const User*, std::vector<Membership>> joined;
+    };
+
+    size_t shardCount;
+    std::unique_ptr<Shard[]> shards;
+    std::unique_ptr<UserStripe[]> stripes;
+    std::atomic<uint32_t> nextShard{0};
+
+    // Room ids interleave shards: the low part picks the shard
+    Shard& shardOf(uint32_t room) {
+        return shards[room % shardCount];
+    }
+
+    Room* findRoom(Shard& shard, uint32_t room) {
+        size_t index = room / shardCount;
+        return index < shard.rooms.size() ? &shard.rooms[index] : nullptr;
+    }
+
+    UserStripe& stripeOf(const User* user) {
+        return stripes[std::hash<const User*>()(user) % shardCount];
+    }
+
+public:
+    explicit ShardedChatMediator(size_t shardCount = 4 * std::max(1u, std::thread::hardware_concurrency()))
+        : shardCount(std::max<size_t>(1, shardCount)),
+          shards(std::make_unique<Shard[]>(this->shardCount)),
+          stripes(std::make_unique<UserStripe[]>(this->shardCount)) {}
+
+    uint32_t createRoom() {
+        uint32_t shardIndex = nextShard.fetch_add(1, std::memory_order_relaxed) % shardCount;
+        Shard& shard = shards[shardIndex];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.rooms.emplace_back();
+        return static_cast<uint32_t>((shard.rooms.size() - 1) * shardCount + shardIndex);
+    }
+
+    Membership join(uint32_t room, User* user) {
+        Membership membership{room, 0, 0};
+        Shard& shard = shardOf(room);
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            Room* target = findRoom(shard, room);
+            if (!target) {
+                throw std::out_of_range("ShardedChatMediator: no room " + std::to_string(room));
+            }
+            if (target->freeSlots.empty()) {
+                membership.slot = static_cast<uint32_t>(target->slotPositions.size());
+                target->slotPositions.push_back(0);
+                target->slotGenerations.push_back(0);
+            } else {
+                membership.slot = target->freeSlots.back();
+                target->freeSlots.pop_back();
+            }
+            membership.generation = target->slotGenerations[membership.slot];
+            target->slotPositions[membership.slot] = static_cast<uint32_t>(target->members.size());
+            target->memberSlots.push_back(membership.slot);
+            target->members.push_back(user);
+        }
+        UserStripe& stripe = stripeOf(user);
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        stripe.joined[user].push_back(membership);
+        return membership;
+    }
+
+    // Returns false if the membership was already gone
+    bool leave(const Membership& membership) {
+        User* user;
+        Shard& shard = shardOf(membership.room);
+        {
+            std::unique_lock<std::mutex> lock(shard.mutex);
+            Room* room = findRoom(shard, membership.room);
+            if (!room || !room->holds(membership)) {
+                return false;
+            }
+            uint32_t position = room->slotPositions[membership.slot];
+            user = room->members[position];
+            room->members[position] = room->members.back();
+            room->memberSlots[position] = room->memberSlots.back();
+            room->slotPositions[room->memberSlots[position]] = position;
+            room->members.pop_back();
+            room->memberSlots.pop_back();
+            ++room->slotGenerations[membership.slot];
+            room->freeSlots.push_back(membership.slot);
+
+            // Broadcasts ticketed from here on cannot see the user
+            if (deliveryDepth == 0) {
+                uint64_t removedAt = shard.nextTicket;
+                ++shard.waiters;
+                shard.delivered.wait(lock, [&] {
+                    return std::all_of(shard.inFlight.begin(), shard.inFlight.end(),
+                                       [removedAt](uint64_t ticket) { return ticket >= removedAt; });
+                });
+                --shard.waiters;
+            }
+        }
+        // A user is in few rooms, so a scan of their own list is cheap
+        UserStripe& stripe = stripeOf(user);
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        auto entry = stripe.joined.find(user);
+        if (entry != stripe.joined.end()) {
+            auto& list = entry->second;
+            for (size_t i = 0; i < list.size(); ++i) {
+                if (list[i].room == membership.room && list[i].slot == membership.slot &&
+                    list[i].generation == membership.generation) {
+                    list[i] = list.back();
+                    list.pop_back();
+                    break;
+                }
+            }
+            if (list.empty()) {
+                stripe.joined.erase(entry);
+            }
+        }
+        return true;
+    }
+
+    // Deliver to every other member of the sender's room. Returns the number
+    // of recipients, or 0 if the membership is stale.
+    size_t broadcast(const Membership& from, std::string_view text) {
+        static thread_local std::vector<User*> recipients;
+        User* sender;
+        uint64_t ticket;
+        Shard& shard = shardOf(from.room);
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            Room* room = findRoom(shard, from.room);
+            if (!room || !room->holds(from)) {
+                return 0;
+            }
+            // The sender's position is known, so no per-recipient sender check
+            uint32_t position = room->slotPositions[from.slot];
+            sender = room->members[position];
+            recipients.assign(room->members.begin(), room->members.begin() + position);
+            recipients.insert(recipients.end(), room->members.begin() + position + 1, room->members.end());
+            ticket = shard.nextTicket++;
+            shard.inFlight.push_back(ticket);
+        }
+        Delivery delivery(shard, ticket);
+        // Deliveries may re-enter broadcast() on this thread, so work on a copy
+        std::vector<User*> batch;
+        batch.swap(recipients);
+        Message shared(sender->getName(), text);
+        for (User* user : batch) {
+            user->receiveMessage(shared);
+        }
+        size_t delivered = batch.size();
+        batch.clear();
+        if (recipients.capacity() < batch.capacity()) {
+            recipients.swap(batch);  // Keep the larger buffer for the next call
+        }
+        return delivered;
+    }
+
+    // ChatMediator entry point: post to every room the sender has joined
+    void sendMessage(const std::string& message, User* sender) override {
+        std::vector<Membership> rooms;
+        {
+            UserStripe& stripe = stripeOf(sender);
+            std::lock_guard<std::mutex> lock(stripe.mutex);
+            auto entry = stripe.joined.find(sender);
+            if (entry != stripe.joined.end()) {
+                rooms = entry->second;
+            }
+        }
+        for (const Membership& membership : rooms) {
+            broadcast(membership, message);
+        }
+    }
+
+    size_t memberCount(uint32_t room) {
+        Shard& shard = shardOf(room);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        Room* target = findRoom(shard, room);
+        return target ? target->members.size() : 0;
+    }
+};
+
+// Step 7: Serve a ChatRoom over TCP or Unix-domain sockets
+// Every frame is a 4-byte little-endian header, with the frame type in the
+// top byte and the payload length in the low 24 bits, followed by the
+// payload. A client sends Join (payload: its name) once and then Say
+// (payload: text). The server answers Join with Welcome, and relays each Say
+// to the other members as Deliver (payload: "sender: text").
+namespace wire {
+enum class FrameType : uint8_t { Join = 1, Welcome = 2, Say = 3, Deliver = 4 };
+
+constexpr size_t HeaderSize = 4;
+constexpr size_t MaxPayload = (size_t(1) << 24) - 1;
+
+inline uint32_t encodeHeader(FrameType type, size_t length) {
+    return htole32(uint32_t(type) << 24 | uint32_t(length));
+}
+
+inline void appendFrame(std::string& out, FrameType type, std::string_view payload) {
+    uint32_t header = encodeHeader(type, payload.size());
+    out.append(reinterpret_cast<const char*>(&header), HeaderSize);
+    out.append(payload);
+}
+
+// Calls onFrame(type, payload) for each complete frame at the front of
+// buffer. Returns the bytes consumed, or SIZE_MAX on an unknown frame type.
+template <typename OnFrame>
+size_t parseFrames(std::string_view buffer, OnFrame&& onFrame) {
+    size_t offset = 0;
+    while (buffer.size() - offset >= HeaderSize) {
+        uint32_t header;
+        std::memcpy(&header, buffer.data() + offset, HeaderSize);
+        header = le32toh(header);
+        auto type = static_cast<FrameType>(header >> 24);
+        size_t length = header & MaxPayload;
+        if (type < FrameType::Join || type > FrameType::Deliver) {
+            return SIZE_MAX;
+        }
+        if (buffer.size() - offset - HeaderSize < length) {
+            break;
+        }
+        onFrame(type, buffer.substr(offset + HeaderSize, length));
+        offset += HeaderSize + length;
+    }
+    return offset;
+}
+}  // namespace wire
+
+// A single-threaded epoll loop in front of a ChatRoom. Broadcasts only queue
+// frames: each queued frame is a 4-byte header plus a reference to the
+// broadcast's shared Message, so fan-out copies no text. After each batch of
+// events, every connection with queued output gets one writev() covering
+// all of it. A client that falls more than maxQueuedBytes behind is
+// disconnected rather than buffered without bound, and so is one that leaves
+// more than maxInputBytes of an unfinished frame pending. Reads land in one
+// buffer shared by all connections; only a trailing partial frame is copied
+// into the connection's own input.
+class SocketChatServer {
+private:
+    struct Connection;
+
+    // A connected client, as the ChatRoom sees it
+    class RemoteUser : public User {
+    private:
+        SocketChatServer& server;
+        Connection& connection;
+
+    public:
+        RemoteUser(SocketChatServer& server, Connection& connection)
+            : User(server.room, ""), server(server), connection(connection) {}
+
+        void setName(std::string_view newName) {
+            name = newName;
+        }
+
+        void receiveMessage(const Message& message) const override {
+            server.queueFrame(connection, wire::FrameType::Deliver, message);
+        }
+
+        void sendMessage(const std::string& message) override {
+            mediator.sendMessage(message, this);
+        }
+    };
+
+    struct OutgoingFrame {
+        uint32_t header;
+        Message message;
+    };
+
+    struct Connection {
+        int fd;
+        std::unique_ptr<RemoteUser> user;
+        std::string input;  // Unparsed tail of an incomplete frame
+        std::deque<OutgoingFrame> output;
+        size_t frontWritten = 0;  // Bytes of output.front() already sent
+        size_t queuedBytes = 0;
+        bool joined = false;
+        bool dirty = false;  // Listed for the end-of-batch flush
+        bool watchingWrites = false;
+        bool closing = false;
+    };
+
+    ChatRoom room;
+    int epollFd = -1;
+    int wakeFd = -1;
+    std::vector<int> listeners;
+    std::vector<std::string> unixPaths;
+    std::vector<std::unique_ptr<Connection>> connections;  // Indexed by fd
+    std::vector<Connection*> dirty;
+    std::vector<Connection*> closing;
+    std::atomic<size_t> openConnections{0};
+    std::atomic<bool> stopping{false};
+    size_t maxQueuedBytes;
+    size_t maxInputBytes;
+    std::unique_ptr<char[]> receiveBuffer;
+
+    static constexpr size_t ReceiveBufferSize = 64 * 1024;
+
+    static std::runtime_error systemError(const std::string& what) {
+        return std::runtime_error("SocketChatServer: " + what + ": " + std::strerror(errno));
+    }
+
+    void watch(int fd, uint32_t events, int operation) {
+        epoll_event event{};
+        event.events = events;
+        event.data.fd = fd;
+        if (epoll_ctl(epollFd, operation, fd, &event) != 0) {
+            throw systemError("epoll_ctl");
+        }
+    }
+
+    void addListener(int fd) {
+        if (listen(fd, SOMAXCONN) != 0) {
+            close(fd);
+            throw systemError("listen");
+        }
+        watch(fd, EPOLLIN, EPOLL_CTL_ADD);
+        listeners.push_back(fd);
+    }
+
+    void acceptAll(int listener) {
+        for (;;) {
+            int fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                return;  // EAGAIN, or a client that gave up before we got to it
+            }
+            int on = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));  // Fails harmlessly on Unix sockets
+            if (static_cast<size_t>(fd) >= connections.size()) {
+                connections.resize(fd + 1);
+            }
+            auto connection = std::make_unique<Connection>();
+            connection->fd = fd;
+            connection->user = std::make_unique<RemoteUser>(*this, *connection);
+            connections[fd] = std::move(connection);
+            watch(fd, EPOLLIN, EPOLL_CTL_ADD);
+            openConnections.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void markClosing(Connection& connection) {
+        if (!connection.closing) {
+            connection.closing = true;
+            closing.push_back(&connection);
+        }
+    }
+
+    // Runs inside ChatRoom::sendMessage, so it must not change room membership
+    void queueFrame(Connection& connection, wire::FrameType type, const Message& message) {
+        size_t bytes = wire::HeaderSize + message.text().size();
+        if (connection.closing || message.text().size() > wire::MaxPayload) {
+            return;
+        }
+        if (connection.queuedBytes + bytes > maxQueuedBytes) {
+            markClosing(connection);  // Too slow a reader
+            return;
+        }
+        connection.output.push_back({wire::encodeHeader(type, message.text().size()), message});
+        connection.queuedBytes += bytes;
+        if (!connection.dirty) {
+            connection.dirty = true;
+            dirty.push_back(&connection);
+        }
+    }
+
+    void handleFrame(Connection& connection, wire::FrameType type, std::string_view payload) {
+        if (connection.closing) {
+            return;
+        }
+        if (type == wire::FrameType::Join && !connection.joined) {
+            connection.user->setName(payload);
+            connection.joined = true;
+            room.addUser(connection.user.get());
+            queueFrame(connection, wire::FrameType::Welcome, Message());
+        } else if (type == wire::FrameType::Say && connection.joined) {
+            connection.user->sendMessage(std::string(payload));
+        } else {
+            markClosing(connection);  // Protocol violation
+        }
+    }
+
+    void readFrom(Connection& connection) {
+        // One read per event keeps a busy client from starving the others;
+        // the level-triggered epoll reports it again if more is waiting
+        ssize_t received = read(connection.fd, receiveBuffer.get(), ReceiveBufferSize);
+        if (received <= 0) {
+            if (received == 0 || (errno != EAGAIN && errno != EINTR)) {
+                markClosing(connection);
+            }
+            return;
+        }
+        // Whole frames are parsed straight out of the shared buffer unless an
+        // earlier partial frame has to be completed first
+        std::string_view pending(receiveBuffer.get(), received);
+        if (!connection.input.empty()) {
+            connection.input.append(pending);
+            pending = connection.input;
+        }
+        size_t consumed = wire::parseFrames(pending, [&](wire::FrameType type, std::string_view payload) {
+            handleFrame(connection, type, payload);
+        });
+        if (consumed == SIZE_MAX || pending.size() - consumed > maxInputBytes) {
+            markClosing(connection);
+            return;
+        }
+        if (connection.input.empty()) {
+            connection.input.assign(pending.substr(consumed));
+        } else {
+            connection.input.erase(0, consumed);
+        }
+    }
+
+    void watchWrites(Connection& connection, bool enable) {
+        if (connection.watchingWrites != enable) {
+            connection.watchingWrites = enable;
+            watch(connection.fd, enable ? uint32_t(EPOLLIN | EPOLLOUT) : uint32_t(EPOLLIN), EPOLL_CTL_MOD);
+        }
+    }
+
+    void flush(Connection& connection) {
+        while (!connection.output.empty()) {
+            // Header and text of as many frames as fit, resuming mid-frame
+            iovec vectors[64];
+            int count = 0;
+            size_t skip = connection.frontWritten;
+            for (auto frame = connection.output.begin(); frame != connection.output.end() && count + 2 <= 64;
+                 ++frame) {
+                std::string_view text = frame->message.text();
+                if (skip < wire::HeaderSize) {
+                    vectors[count++] = {reinterpret_cast<char*>(&frame->header) + skip, wire::HeaderSize - skip};
+                    if (!text.empty()) {
+                        vectors[count++] = {const_cast<char*>(text.data()), text.size()};
+                    }
+                } else {
+                    size_t sent = skip - wire::HeaderSize;
+                    vectors[count++] = {const_cast<char*>(text.data()) + sent, text.size() - sent};
+                }
+                skip = 0;
+            }
+
+            ssize_t written = writev(connection.fd, vectors, count);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == EAGAIN) {
+                    watchWrites(connection, true);  // Resume when the socket drains
+                } else {
+                    markClosing(connection);
+                }
+                return;
+            }
+
+            connection.queuedBytes -= written;
+            size_t remaining = written;
+            while (remaining > 0) {
+                size_t frameLeft =
+                    wire::HeaderSize + connection.output.front().message.text().size() - connection.frontWritten;
+                if (remaining < frameLeft) {
+                    connection.frontWritten += remaining;
+                    break;
+                }
+                remaining -= frameLeft;
+                connection.output.pop_front();
+                connection.frontWritten = 0;
+            }
+        }
+        watchWrites(connection, false);
+    }
+
+    void closeConnection(Connection& connection) {
+        if (connection.joined) {
+            room.removeUser(connection.user.get());
+        }
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, connection.fd, nullptr);
+        int fd = connection.fd;
+        close(fd);
+        connections[fd].reset();
+        openConnections.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+public:
+    explicit SocketChatServer(size_t maxQueuedBytes = 4 << 20, size_t maxInputBytes = 1 << 20)
+        : maxQueuedBytes(maxQueuedBytes),
+          maxInputBytes(maxInputBytes),
+          receiveBuffer(std::make_unique_for_overwrite<char[]>(ReceiveBufferSize)) {
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (epollFd < 0 || wakeFd < 0) {
+            int error = errno;
+            if (epollFd >= 0) close(epollFd);
+            if (wakeFd >= 0) close(wakeFd);
+            errno = error;
+            throw systemError("epoll_create1/eventfd");
+        }
+        watch(wakeFd, EPOLLIN, EPOLL_CTL_ADD);
+    }
+
+    ~SocketChatServer() {
+        for (auto& connection : connections) {
+            if (connection) {
+                closeConnection(*connection);
+            }
+        }
+        for (int fd : listeners) {
+            close(fd);
+        }
+        for (const std::string& path : unixPaths) {
+            unlink(path.c_str());
+        }
+        close(wakeFd);
+        close(epollFd);
+    }
+
+    SocketChatServer(const SocketChatServer&) = delete;
+    SocketChatServer& operator=(const SocketChatServer&) = delete;
+
+    // Listens on 127.0.0.1; port 0 picks a free port. Returns the bound port.
+    uint16_t listenTcp(uint16_t port = 0) {
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            throw systemError("socket");
+        }
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(address);
+        if (bind(fd, reinterpret_cast<sockaddr*>(&address), length) != 0 ||
+            getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+            int error = errno;
+            close(fd);
+            errno = error;
+            throw systemError("bind 127.0.0.1:" + std::to_string(port));
+        }
+        addListener(fd);
+        return ntohs(address.sin_port);
+    }
+
+    void listenUnix(const std::string& path) {
+        sockaddr_un address{};
+        if (path.size() >= sizeof(address.sun_path)) {
+            throw std::invalid_argument("SocketChatServer: socket path too long: " + path);
+        }
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            throw systemError("socket");
+        }
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+        unlink(path.c_str());
+        if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            int error = errno;
+            close(fd);
+            errno = error;
+            throw systemError("bind " + path);
+        }
+        unixPaths.push_back(path);
+        addListener(fd);
+    }
+
+    // Serve until stop() is called
+    void run() {
+        std::vector<epoll_event> events(256);
+        while (!stopping.load(std::memory_order_acquire)) {
+            int ready = epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), -1);
+            if (ready < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw systemError("epoll_wait");
+            }
+            for (int i = 0; i < ready; ++i) {
+                int fd = events[i].data.fd;
+                if (fd == wakeFd) {
+                    uint64_t ignored;
+                    [[maybe_unused]] ssize_t drained = read(wakeFd, &ignored, sizeof(ignored));
+                    continue;
+                }
+                if (std::find(listeners.begin(), listeners.end(), fd) != listeners.end()) {
+                    acceptAll(fd);
+                    continue;
+                }
+                Connection* connection = connections[fd].get();
+                if (!connection || connection->closing) {
+                    continue;
+                }
+                if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                    markClosing(*connection);
+                    continue;
+                }
+                if (events[i].events & EPOLLIN) {
+                    readFrom(*connection);
+                }
+                if ((events[i].events & EPOLLOUT) && !connection->closing) {
+                    flush(*connection);
+                }
+            }
+
+            // One writev per connection covers everything this batch queued
+            for (Connection* connection : dirty) {
+                connection->dirty = false;
+                if (!connection->closing && !connection->watchingWrites) {
+                    flush(*connection);
+                }
+            }
+            dirty.clear();
+            for (Connection* connection : closing) {
+                closeConnection(*connection);
+            }
+            closing.clear();
+        }
+    }
+
+    // Safe to call from any thread
+    void stop() {
+        stopping.store(true, std::memory_order_release);
+        uint64_t one = 1;
+        [[maybe_unused]] ssize_t written = write(wakeFd, &one, sizeof(one));
+    }
+
+    size_t connectionCount() const {
+        return openConnections.load(std::memory_order_relaxed);
+    }
+};
+
+// Step 8: A loopback load generator for SocketChatServer
+// Opens the connections, joins them all, then runs rounds in which the first
+// `senders` clients each post a timestamped message. A round ends once every
+// other client has received every message, so the latency covers the server
+// and the client's read path.
+struct LoadReport {
+    size_t connections = 0;
+    uint64_t delivered = 0;
+    double seconds = 0;
+    uint64_t p50Nanoseconds = 0;
+    uint64_t p99Nanoseconds = 0;
+    uint64_t p999Nanoseconds = 0;
+    bool timedOut = false;
+    size_t disconnected = 0;  // Clients the server closed or reset mid-run
+};
+
+// Blocking connects; both return -1 on failure
+int connectTcp(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        return fd;
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    return -1;
+}
+
+int connectUnix(const std::string& path) {
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+        return fd;
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    return -1;
+}
+
+LoadReport runChatLoad(const std::function<int()>& connectClient, size_t connectionCount, size_t senders,
+                       size_t rounds) {
+    LoadReport report;
+    std::vector<int> fds;
+    std::vector<std::string> inputs;
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) {
+        return report;
+    }
+
+    auto sendAll = [](int fd, const std::string& bytes) {
+        size_t sent = 0;
+        while (sent < bytes.size()) {
+            ssize_t n = write(fd, bytes.data() + sent, bytes.size() - sent);
+            if (n > 0) {
+                sent += n;
+            } else if (n < 0 && errno == EAGAIN) {
+                pollfd waiting{fd, POLLOUT, 0};
+                poll(&waiting, 1, 1000);
+            } else if (n < 0 && errno != EINTR) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    std::string frame;
+    for (size_t i = 0; i < connectionCount; ++i) {
+        int fd = connectClient();
+        if (fd < 0) {
+            break;  // Out of descriptors or refused: report what we hold
+        }
+        frame.clear();
+        wire::appendFrame(frame, wire::FrameType::Join, "client" + std::to_string(i));
+        if (!sendAll(fd, frame)) {
+            close(fd);
+            break;
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u32 = static_cast<uint32_t>(fds.size());
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+        fds.push_back(fd);
+    }
+    inputs.resize(fds.size());
+    report.connections = fds.size();
+
+    LatencyHistogram latency;
+    size_t welcomed = 0;
+    uint64_t delivered = 0;
+    auto onFrame = [&](wire::FrameType type, std::string_view payload) {
+        if (type == wire::FrameType::Welcome) {
+            ++welcomed;
+        } else if (type == wire::FrameType::Deliver && payload.size() >= sizeof(int64_t)) {
+            int64_t sentAt;
+            std::memcpy(&sentAt, payload.data() + payload.size() - sizeof(sentAt), sizeof(sentAt));
+            int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now().time_since_epoch())
+                              .count();
+            latency.record(static_cast<uint64_t>(now - sentAt));
+            ++delivered;
+        }
+    };
+
+    // Read whatever arrives until done() holds; false if the server went
+    // quiet or closed a client, since its messages can then never arrive. A
+    // closed socket stays readable, so it leaves the epoll set at once.
+    std::vector<epoll_event> events(256);
+    auto pump = [&](auto done) {
+        while (!done()) {
+            int ready = epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), 5000);
+            if (ready == 0) {
+                report.timedOut = true;
+                return false;
+            }
+            if (ready < 0 && errno != EINTR) {
+                return false;
+            }
+            bool closed = false;
+            for (int i = 0; i < ready; ++i) {
+                size_t index = events[i].data.u32;
+                std::string& input = inputs[index];
+                char buffer[16 * 1024];
+                ssize_t n;
+                while ((n = read(fds[index], buffer, sizeof(buffer))) > 0 || (n < 0 && errno == EINTR)) {
+                    if (n > 0) {
+                        input.append(buffer, n);
+                    }
+                }
+                int error = n < 0 ? errno : 0;
+                size_t consumed = wire::parseFrames(input, onFrame);
+                input.erase(0, consumed == SIZE_MAX ? input.size() : consumed);
+                if (n == 0 || (error != EAGAIN && error != EWOULDBLOCK)) {
+                    epoll_ctl(epollFd, EPOLL_CTL_DEL, fds[index], nullptr);
+                    ++report.disconnected;
+                    closed = true;
+                }
+            }
+            if (closed) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    senders = std::min(senders, fds.size());
+    auto start = std::chrono::steady_clock::now();
+    bool ok = pump([&] { return welcomed == fds.size(); });
+    uint64_t expected = 0;
+    for (size_t round = 0; ok && round < rounds; ++round) {
+        for (size_t s = 0; s < senders; ++s) {
+            int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now().time_since_epoch())
+                              .count();
+            frame.clear();
+            wire::appendFrame(frame, wire::FrameType::Say,
+                              std::string_view(reinterpret_cast<const char*>(&now), sizeof(now)));
+            sendAll(fds[s], frame);
+        }
+        expected += senders * (fds.size() - 1);
+        ok = pump([&] { return delivered >= expected; });
+    }
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report.delivered = delivered;
+
+    std::vector<uint64_t> totals;
+    latency.mergeInto(totals);
+    report.p50Nanoseconds = LatencyHistogram::percentile(totals, 0.50);
+    report.p99Nanoseconds = LatencyHistogram::percentile(totals, 0.99);
+    report.p999Nanoseconds = LatencyHistogram::percentile(totals, 0.999);
+
+    for (int fd : fds) {
+        close(fd);
+    }
+    close(epollFd);
+    return report;
+}
+
+void printLoadReport(const char* label, const LoadReport& report) {
+    std::cout << label << ": " << report.connections << " connections held, " << report.delivered / report.seconds / 1e6
+              << " M messages/s delivered, latency p50 " << report.p50Nanoseconds / 1e3 << " us, p99 "
+              << report.p99Nanoseconds / 1e3 << " us, p999 " << report.p999Nanoseconds / 1e3 << " us"
+              << (report.timedOut ? " (TIMED OUT)" : "")
+              << (report.disconnected ? " (" + std::to_string(report.disconnected) + " DISCONNECTED)" : "")
+              << std::endl;
+}
+
+// Each socket is a descriptor on both ends, so lift the soft limit
+void raiseDescriptorLimit() {
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+// Step 9: Benchmarks
+// 9a: Broadcast fan-out allocations, counted by allocation_counter.h
+// Records what it receives without printing, so the benchmark measures delivery
+class SilentUser : public User {
+private:
+    mutable size_t bytesReceived = 0;
+
+public:
+    using User::User;
+
+    void receiveMessage(const Message& message) const override {
+        bytesReceived += message.text().size();
+    }
+
+    // The pre-sharing delivery path: one formatted string per recipient
+    void receiveText(const std::string& text) const {
+        bytesReceived += text.size();
+    }
+
+    size_t getBytesReceived() const {
+        return bytesReceived;
+    }
+};
+
+void benchmarkFanOut(size_t userCount, size_t broadcasts) {
+    ChatRoom room;
+    std::vector<std::unique_ptr<SilentUser>> users;
+    users.reserve(userCount);
+    for (size_t i = 0; i < userCount; ++i) {
+        users.push_back(std::make_unique<SilentUser>(room, "user" + std::to_string(i)));
+        room.addUser(users.back().get());
+    }
+    const std::string text = "The quarterly report is ready for review";
+    SilentUser* sender = users.front().get();
+
+    size_t before = allocationCount;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t b = 0; b < broadcasts; ++b) {
+        for (auto& user : users) {
+            if (user.get() != sender) {
+                user->receiveText(sender->getName() + ": " + text);
+            }
+        }
+    }
+    double perRecipientSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    size_t perRecipientAllocations = allocationCount - before;
+
+    before = allocationCount;
+    start = std::chrono::steady_clock::now();
+    for (size_t b = 0; b < broadcasts; ++b) {
+        room.sendMessage(text, sender);
+    }
+    double sharedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    size_t sharedAllocations = allocationCount - before;
+
+    std::cout << "Fan-out to " << userCount << " users, " << broadcasts << " broadcasts:" << std::endl;
+    std::cout << "Per-recipient strings: " << double(perRecipientAllocations) / broadcasts
+              << " allocations/broadcast, " << perRecipientSeconds * 1e6 / broadcasts << " us/broadcast" << std::endl;
+    std::cout << "Shared message:        " << double(sharedAllocations) / broadcasts
+              << " allocations/broadcast, " << sharedSeconds * 1e6 / broadcasts << " us/broadcast ("
+              << perRecipientSeconds / sharedSeconds << "x)" << std::endl;
+    if (users.back()->getBytesReceived() != 2 * broadcasts * (sender->getName().size() + 2 + text.size())) {
+        std::cout << "Delivered byte count does not match!" << std::endl;
+    }
+}
+
+// 9b: Asynchronous delivery throughput and latency under each overflow policy
+void benchmarkAsyncDelivery(size_t userCount, size_t broadcasts) {
+    const std::string text = "The quarterly report is ready for review";
+    size_t workerCount = std::max(1u, std::thread::hardware_concurrency());
+    std::cout << "\nAsync delivery to " << userCount << " users, " << broadcasts << " broadcasts, "
+              << workerCount << " worker(s):" << std::endl;
+
+    for (OverflowPolicy policy : {OverflowPolicy::Block, OverflowPolicy::Drop}) {
+        std::vector<std::unique_ptr<SilentUser>> users;
+        AsyncChatRoom room(workerCount, 64, policy, 32);
+        users.reserve(userCount);
+        for (size_t i = 0; i < userCount; ++i) {
+            users.push_back(std::make_unique<SilentUser>(room, "user" + std::to_string(i)));
+            room.addUser(users.back().get());
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t b = 0; b < broadcasts; ++b) {
+            room.sendMessage(text, users[b % userCount].get());
+        }
+        room.flush();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        DeliveryStats stats = room.stats();
+        std::cout << (policy == OverflowPolicy::Block ? "Block: " : "Drop:  ") << stats.delivered / seconds / 1e6
+                  << " M messages/s, latency p50 " << stats.p50Nanoseconds / 1e3 << " us, p99 "
+                  << stats.p99Nanoseconds / 1e3 << " us, p999 " << stats.p999Nanoseconds / 1e3 << " us, "
+                  << stats.dropped << " dropped" << std::endl;
+        if (stats.delivered + stats.dropped != broadcasts * (userCount - 1)) {
+            std::cout << "Delivered and dropped counts do not add up!" << std::endl;
+        }
+    }
+}
+
+// 9c: Concurrent broadcasts over thousands of rooms, and membership churn
+void benchmarkShardedRooms(size_t roomCount, size_t usersPerRoom, size_t broadcastsPerThread) {
+    const std::string text = "The quarterly report is ready for review";
+    size_t threadCount = std::max(4u, std::thread::hardware_concurrency());
+    std::cout << "\n" << roomCount << " rooms of " << usersPerRoom << " users, " << threadCount
+              << " sending threads:" << std::endl;
+
+    for (size_t shardCount : {size_t(1), size_t(64)}) {
+        ShardedChatMediator mediator(shardCount);
+        std::vector<std::unique_ptr<SilentUser>> users;
+        std::vector<Membership> senders;
+        users.reserve(roomCount * usersPerRoom);
+        for (size_t r = 0; r < roomCount; ++r) {
+            uint32_t room = mediator.createRoom();
+            for (size_t u = 0; u < usersPerRoom; ++u) {
+                users.push_back(std::make_unique<SilentUser>(mediator, "user" + std::to_string(users.size())));
+                Membership membership = mediator.join(room, users.back().get());
+                if (u == 0) {
+                    senders.push_back(membership);
+                }
+            }
+        }
+
+        std::atomic<size_t> delivered{0};
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < threadCount; ++t) {
+            threads.emplace_back([&, t] {
+                size_t local = 0;
+                for (size_t i = 0; i < broadcastsPerThread; ++i) {
+                    local += mediator.broadcast(senders[(i * threadCount + t) % senders.size()], text);
+                }
+                delivered += local;
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << shardCount << " shard(s): " << threadCount * broadcastsPerThread / seconds / 1e6
+                  << " M broadcasts/s, " << delivered / seconds / 1e6 << " M deliveries/s" << std::endl;
+    }
+
+    // Leave and rejoin random members of one large room
+    const size_t members = 100000;
+    const size_t churn = 1000000;
+    ShardedChatMediator mediator;
+    uint32_t room = mediator.createRoom();
+    std::vector<std::unique_ptr<SilentUser>> users;
+    std::vector<Membership> handles;
+    std::vector<User*> plainList;
+    for (size_t i = 0; i < members; ++i) {
+        users.push_back(std::make_unique<SilentUser>(mediator, "member" + std::to_string(i)));
+        handles.push_back(mediator.join(room, users.back().get()));
+        plainList.push_back(users.back().get());
+    }
+    uint64_t state = 88172645463325252ull;
+    auto nextRandom = [&state] {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < churn; ++i) {
+        size_t index = nextRandom() % members;
+        mediator.leave(handles[index]);
+        handles[index] = mediator.join(room, users[index].get());
+    }
+    double handleSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const size_t scans = 1000;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < scans; ++i) {
+        User* user = users[nextRandom() % members].get();
+        plainList.erase(std::find(plainList.begin(), plainList.end(), user));
+        plainList.push_back(user);
+    }
+    double scanSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Leave+join in a " << members << "-member room: " << handleSeconds * 1e9 / churn
+              << " ns/op with handles, " << scanSeconds * 1e9 / scans << " ns/op with find+erase on a vector"
+              << (mediator.memberCount(room) == members ? "" : " (member count MISMATCH)") << std::endl;
+}
+
+// 9d: Socket transport over loopback, Unix-domain and TCP
+void benchmarkSocketTransport(size_t connections, size_t senders, size_t rounds) {
+    raiseDescriptorLimit();
+    std::cout << "\nSocket transport, " << senders << " senders, " << rounds << " rounds:" << std::endl;
+
+    // A private directory keeps another user from squatting on the socket path
+    std::string directory = (std::filesystem::temp_directory_path() / "mediator_bench.XXXXXX").string();
+    if (!mkdtemp(directory.data())) {
+        throw std::runtime_error("mkdtemp " + directory + ": " + std::strerror(errno));
+    }
+    std::string path = directory + "/chat.sock";
+    for (bool overTcp : {false, true}) {
+        SocketChatServer server;
+        std::function<int()> connectClient;
+        if (overTcp) {
+            uint16_t port = server.listenTcp();
+            connectClient = [port] { return connectTcp(port); };
+        } else {
+            server.listenUnix(path);
+            connectClient = [&path] { return connectUnix(path); };
+        }
+        std::thread serverThread([&server] { server.run(); });
+        LoadReport report = runChatLoad(connectClient, connections, senders, rounds);
+        server.stop();
+        serverThread.join();
+        printLoadReport(overTcp ? "TCP " : "Unix", report);
+    }
+    rmdir(directory.c_str());
+}
+
+// Step 10: Use the Mediator pattern in the client code
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        benchmarkFanOut(10000, 1000);
+        benchmarkAsyncDelivery(100000, 200);
+        benchmarkShardedRooms(4000, 25, 250000);
+        benchmarkSocketTransport(2000, 10, 200);
+        return 0;
+    }
+    // Run the server and the load generator as separate processes
+    if (argc > 1 && std::string(argv[1]) == "--serve") {
+        raiseDescriptorLimit();
+        SocketChatServer server;
+        uint16_t port = server.listenTcp(argc > 2 ? static_cast<uint16_t>(std::stoi(argv[2])) : 7000);
+        std::cout << "Serving on 127.0.0.1:" << port << std::endl;
+        server.run();
+        return 0;
+    }
+    if (argc > 2 && std::string(argv[1]) == "--load") {
+        raiseDescriptorLimit();
+        auto port = static_cast<uint16_t>(std::stoi(argv[2]));
+        size_t connections = argc > 3 ? std::stoul(argv[3]) : 1000;
+        size_t senders = argc > 4 ? std::stoul(argv[4]) : 10;
+        size_t rounds = argc > 5 ? std::stoul(argv[5]) : 100;
+        printLoadReport("TCP", runChatLoad([port] { return connectTcp(port); }, connections, senders, rounds));
+        return 0;
+    }
+
     // Create the chatroom (mediator)
     ChatRoom chatRoom;
 
@@ -75,5 +1682,33 @@ int main() {
     user2.sendMessage("Hi Alice!");
     user3.sendMessage("Hey folks!");
 
+    // The same conversation through per-user mailboxes and delivery workers
+    AsyncChatRoom asyncRoom(2);
+    User dave(asyncRoom, "Dave");
+    User erin(asyncRoom, "Erin");
+    asyncRoom.addUser(&dave);
+    asyncRoom.addUser(&erin);
+    dave.sendMessage("Is anyone around?");
+    asyncRoom.flush();  // Wait for delivery so the output stays in order
+    erin.sendMessage("Here!");
+    asyncRoom.flush();
+
+    // Many rooms on one mediator; members leave in O(1) through their handle
+    ShardedChatMediator rooms;
+    uint32_t general = rooms.createRoom();
+    uint32_t random = rooms.createRoom();
+    User frank(rooms, "Frank");
+    User grace(rooms, "Grace");
+    User heidi(rooms, "Heidi");
+    rooms.join(general, &frank);
+    Membership graceInGeneral = rooms.join(general, &grace);
+    rooms.join(general, &heidi);
+    rooms.join(random, &frank);
+    rooms.join(random, &heidi);
+    frank.sendMessage("Posted to both of my rooms");  // Grace once, Heidi twice
+    rooms.leave(graceInGeneral);
+    rooms.broadcast(rooms.join(random, &grace), "Grace moved to random");
+    std::cout << "General has " << rooms.memberCount(general) << " members" << std::endl;  // Output: 2
+
     return 0;
 }
@@ -1,70 +1,1321 @@
-
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <future>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
 #include <string>
-#include <stack>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Step 1: A persistent, structurally shared text
+// The single replacement that turns one text into another: erase `removed`
+// characters at `offset`, then insert `inserted` there
+struct TextPatch {
+    size_t offset = 0;
+    size_t removed = 0;
+    std::string inserted;
+};
+
+// An implicit treap of text chunks whose nodes never change once built. An
+// edit copies only the nodes on the path to the change (O(log n) of them)
+// and shares every other node and chunk with the text it was made from, so
+// keeping an old version costs only what later edits replaced.
+class PersistentText {
+private:
+    static constexpr size_t MaxChunk = 1024;
+
+    struct Node;
+    using NodePtr = std::shared_ptr<const Node>;
+    using ChunkPtr = std::shared_ptr<const std::string>;
+
+    struct Node {
+        NodePtr left;
+        NodePtr right;
+        ChunkPtr chunk;
+        size_t size;  // Characters in this subtree
+        uint32_t priority;
+    };
+
+    NodePtr root;
+
+    explicit PersistentText(NodePtr root) : root(std::move(root)) {}
+
+    static size_t sizeOf(const NodePtr& node) {
+        return node ? node->size : 0;
+    }
+
+    static uint32_t nextPriority() {
+        static thread_local uint32_t state = 2463534242u;
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    static NodePtr make(NodePtr left, ChunkPtr chunk, NodePtr right, uint32_t priority) {
+        size_t size = sizeOf(left) + chunk->size() + sizeOf(right);
+        return std::make_shared<const Node>(Node{std::move(left), std::move(right), std::move(chunk), size, priority});
+    }
+
+    static NodePtr merge(const NodePtr& a, const NodePtr& b) {
+        if (!a) return b;
+        if (!b) return a;
+        if (a->priority > b->priority) {
+            return make(a->left, a->chunk, merge(a->right, b), a->priority);
+        }
+        return make(merge(a, b->left), b->chunk, b->right, b->priority);
+    }
+
+    // First `position` characters, and the rest
+    static std::pair<NodePtr, NodePtr> split(const NodePtr& node, size_t position) {
+        if (!node || position == 0) return {nullptr, node};
+        if (position >= node->size) return {node, nullptr};
+        size_t leftSize = sizeOf(node->left);
+        size_t chunkEnd = leftSize + node->chunk->size();
+        if (position <= leftSize) {
+            auto [left, right] = split(node->left, position);
+            return {left, make(right, node->chunk, node->right, node->priority)};
+        }
+        if (position >= chunkEnd) {
+            auto [left, right] = split(node->right, position - chunkEnd);
+            return {make(node->left, node->chunk, left, node->priority), right};
+        }
+        // The cut falls inside this chunk; both halves keep the node's priority
+        size_t offset = position - leftSize;
+        auto head = std::make_shared<const std::string>(*node->chunk, 0, offset);
+        auto tail = std::make_shared<const std::string>(*node->chunk, offset);
+        return {make(node->left, std::move(head), nullptr, node->priority),
+                make(nullptr, std::move(tail), node->right, node->priority)};
+    }
+
+    static NodePtr build(std::string_view text) {
+        NodePtr tree;
+        for (size_t offset = 0; offset < text.size(); offset += MaxChunk) {
+            auto chunk = std::make_shared<const std::string>(text.substr(offset, MaxChunk));
+            tree = merge(tree, make(nullptr, std::move(chunk), nullptr, nextPriority()));
+        }
+        return tree;
+    }
+
+    // Fast path: rewrite the one chunk that holds `position` if the text
+    // fits in it. Returns null when it does not.
+    static NodePtr insertIntoChunk(const NodePtr& node, size_t position, std::string_view text) {
+        size_t leftSize = sizeOf(node->left);
+        size_t chunkEnd = leftSize + node->chunk->size();
+        if (node->left && position <= leftSize) {  // At a boundary, extend the earlier chunk
+            NodePtr left = insertIntoChunk(node->left, position, text);
+            return left ? make(std::move(left), node->chunk, node->right, node->priority) : nullptr;
+        }
+        if (position > chunkEnd) {
+            NodePtr right = insertIntoChunk(node->right, position - chunkEnd, text);
+            return right ? make(node->left, node->chunk, std::move(right), node->priority) : nullptr;
+        }
+        if (node->chunk->size() + text.size() > MaxChunk) {
+            return nullptr;
+        }
+        std::string chunk;
+        chunk.reserve(node->chunk->size() + text.size());
+        chunk.append(*node->chunk, 0, position - leftSize).append(text).append(*node->chunk, position - leftSize);
+        return make(node->left, std::make_shared<const std::string>(std::move(chunk)), node->right, node->priority);
+    }
+
+    template <typename Visit>
+    static void visitChunks(const NodePtr& node, Visit& visit) {
+        if (node) {
+            visitChunks(node->left, visit);
+            visit(std::string_view(*node->chunk));
+            visitChunks(node->right, visit);
+        }
+    }
+
+    static size_t countNewBytes(const NodePtr& node, std::unordered_set<const void*>& seen) {
+        if (!node || !seen.insert(node.get()).second) {
+            return 0;
+        }
+        // Each make_shared block also carries a control block of two counters
+        const size_t controlBlock = 2 * sizeof(long);
+        size_t bytes = sizeof(Node) + controlBlock;
+        if (seen.insert(node->chunk.get()).second) {
+            bytes += sizeof(std::string) + controlBlock;
+            if (node->chunk->capacity() >= sizeof(std::string)) {  // Past the small-string buffer
+                bytes += node->chunk->capacity() + 1;
+            }
+        }
+        return bytes + countNewBytes(node->left, seen) + countNewBytes(node->right, seen);
+    }
+
+    // A subtree not yet looked into, or what is left of one chunk
+    struct Piece {
+        const Node* node;
+        std::string_view text;
+    };
+
+    // Replace the subtree on top of the stack by its parts, the part to scan
+    // first ending up on top
+    static void expand(std::vector<Piece>& stack, bool fromEnd) {
+        const Node* node = stack.back().node;
+        stack.pop_back();
+        const NodePtr& later = fromEnd ? node->left : node->right;
+        const NodePtr& sooner = fromEnd ? node->right : node->left;
+        if (later) stack.push_back({later.get(), {}});
+        stack.push_back({nullptr, *node->chunk});
+        if (sooner) stack.push_back({sooner.get(), {}});
+    }
+
+    // Length, up to limit, of the common prefix (or suffix) of two texts
+    static size_t commonRun(const NodePtr& a, const NodePtr& b, bool fromEnd, size_t limit) {
+        std::vector<Piece> x, y;
+        if (a) x.push_back({a.get(), {}});
+        if (b) y.push_back({b.get(), {}});
+        size_t matched = 0;
+        while (matched < limit && !x.empty() && !y.empty()) {
+            if (x.back().node && x.back().node == y.back().node && matched + x.back().node->size <= limit) {
+                matched += x.back().node->size;
+                x.pop_back();
+                y.pop_back();
+                continue;
+            }
+            if (x.back().node) {
+                expand(x, fromEnd);
+                continue;
+            }
+            if (y.back().node) {
+                expand(y, fromEnd);
+                continue;
+            }
+            std::string_view& p = x.back().text;
+            std::string_view& q = y.back().text;
+            size_t span = std::min({p.size(), q.size(), limit - matched});
+            size_t same = 0;
+            if (fromEnd) {
+                const char* pEnd = p.data() + p.size();
+                const char* qEnd = q.data() + q.size();
+                while (same < span && (pEnd == qEnd || pEnd[-1 - same] == qEnd[-1 - same])) ++same;
+                p.remove_suffix(same);
+                q.remove_suffix(same);
+            } else {
+                while (same < span && (p.data() == q.data() || p[same] == q[same])) ++same;
+                p.remove_prefix(same);
+                q.remove_prefix(same);
+            }
+            matched += same;
+            if (same < span) {
+                break;
+            }
+            if (p.empty()) x.pop_back();
+            if (q.empty()) y.pop_back();
+        }
+        return matched;
+    }
+
+public:
+    PersistentText() = default;
+
+    explicit PersistentText(std::string_view text) : root(build(text)) {}
 
-// Step 1: Create the Memento class to store the state
+    size_t size() const {
+        return sizeOf(root);
+    }
+
+    PersistentText inserted(size_t position, std::string_view text) const {
+        position = std::min(position, size());
+        if (text.empty()) {
+            return *this;
+        }
+        if (root) {
+            if (NodePtr updated = insertIntoChunk(root, position, text)) {
+                return PersistentText(std::move(updated));
+            }
+        }
+        auto [left, right] = split(root, position);
+        return PersistentText(merge(merge(left, build(text)), right));
+    }
+
+    PersistentText erased(size_t position, size_t count) const {
+        if (count == 0) {
+            return *this;
+        }
+        auto [left, rest] = split(root, position);
+        auto [removed, right] = split(rest, count);
+        return PersistentText(merge(left, right));
+    }
+
+    PersistentText applied(const TextPatch& patch) const {
+        return erased(patch.offset, patch.removed).inserted(patch.offset, patch.inserted);
+    }
+
+    std::string slice(size_t position, size_t count) const {
+        auto [left, rest] = split(root, position);
+        auto [middle, right] = split(rest, count);
+        return PersistentText(middle).toString();
+    }
+
+    // The patch that turns `from` into `to`. Versions of one document share
+    // most of their subtrees, so the common prefix and suffix are found by
+    // walking both trees and skipping shared subtrees whole.
+    static TextPatch patchBetween(const PersistentText& from, const PersistentText& to) {
+        size_t limit = std::min(from.size(), to.size());
+        size_t prefix = commonRun(from.root, to.root, false, limit);
+        size_t suffix = commonRun(from.root, to.root, true, limit - prefix);
+        return {prefix, from.size() - prefix - suffix, to.slice(prefix, to.size() - prefix - suffix)};
+    }
+
+    template <typename Visit>
+    void forEachChunk(Visit visit) const {
+        visitChunks(root, visit);
+    }
+
+    std::string toString() const {
+        std::string text;
+        text.reserve(size());
+        forEachChunk([&text](std::string_view chunk) { text.append(chunk); });
+        return text;
+    }
+
+    // Heap bytes of the nodes and chunks not already in `seen`, which lets a
+    // caller count the memory of many versions without double-counting what
+    // they share
+    size_t newBytes(std::unordered_set<const void*>& seen) const {
+        return countNewBytes(root, seen);
+    }
+};
+
+// Step 2: Create the Memento class to store the state
+// The state is a PersistentText, so a memento is a root pointer into the
+// shared structure rather than a copy of the document
 class EditorMemento {
 private:
-    std::string state;
+    PersistentText state;
 
 public:
-    explicit EditorMemento(const std::string& state) : state(state) {}
+    explicit EditorMemento(PersistentText state) : state(std::move(state)) {}
 
-    std::string getState() const {
+    const PersistentText& getState() const {
         return state;
     }
 };
 
-// Step 2: Create the Originator class (the text editor)
+// Step 3: Create the Originator class (the text editor)
 class TextEditor {
 private:
-    std::string content;
+    PersistentText content;
 
 public:
     void type(const std::string& words) {
-        content += words;
+        content = content.inserted(content.size(), words);
+    }
+
+    void insert(size_t position, const std::string& words) {
+        content = content.inserted(position, words);
+    }
+
+    void erase(size_t position, size_t count) {
+        content = content.erased(position, count);
+    }
+
+    size_t size() const {
+        return content.size();
     }
 
     std::string getContent() const {
-        return content;
+        return content.toString();
     }
 
-    // Save the current state to a memento
+    // Save the current state to a memento: O(1), it captures the root
     std::unique_ptr<EditorMemento> save() const {
         return std::make_unique<EditorMemento>(content);
     }
 
-    // Restore the state from a memento
+    // Restore the state from a memento: O(1), it swaps the root back in
     void restore(const EditorMemento& memento) {
         content = memento.getState();
     }
 };
 
-// Step 3: Create the Caretaker class to manage mementos (undo/redo functionality)
+// Step 4: Create the Caretaker class to manage mementos (undo/redo functionality)
+// Old history is compressed with a small LZ77 codec in the style of LZ4. Each
+// sequence is a token byte (literal count in the high nibble, match length
+// minus 4 in the low nibble, 15 meaning more length bytes follow), the
+// literals, then a 2-byte little-endian match offset. The final sequence
+// carries literals only.
+namespace lz {
+inline void putLength(std::string& out, size_t length) {
+    for (; length >= 255; length -= 255) {
+        out.push_back(char(255));
+    }
+    out.push_back(char(length));
+}
+
+inline void putSequence(std::string& out, std::string_view literals, size_t offset, size_t matchLength) {
+    size_t extra = matchLength ? matchLength - 4 : 0;
+    out.push_back(char(std::min<size_t>(literals.size(), 15) << 4 | std::min<size_t>(extra, 15)));
+    if (literals.size() >= 15) {
+        putLength(out, literals.size() - 15);
+    }
+    out.append(literals);
+    if (matchLength) {
+        out.push_back(char(offset & 0xFF));
+        out.push_back(char(offset >> 8));
+        if (extra >= 15) {
+            putLength(out, extra - 15);
+        }
+    }
+}
+
+inline std::string compress(std::string_view input) {
+    const size_t minMatch = 4;
+    const size_t maxOffset = 65535;
+    std::vector<uint32_t> table(1 << 14, 0);  // Last position + 1 seen for each 4-byte hash
+    auto hashAt = [&input](size_t position) {
+        uint32_t word;
+        std::memcpy(&word, input.data() + position, sizeof(word));
+        return (word * 2654435761u) >> 18;
+    };
+
+    std::string out;
+    out.reserve(input.size() / 2 + 16);
+    size_t anchor = 0;
+    size_t position = 0;
+    while (position + minMatch <= input.size()) {
+        uint32_t& slot = table[hashAt(position)];
+        size_t candidate = slot;
+        slot = static_cast<uint32_t>(position + 1);
+        if (candidate == 0 || position - (candidate - 1) > maxOffset ||
+            std::memcmp(input.data() + candidate - 1, input.data() + position, minMatch) != 0) {
+            ++position;
+            continue;
+        }
+        size_t match = candidate - 1;
+        size_t length = minMatch;
+        while (position + length < input.size() && input[match + length] == input[position + length]) {
+            ++length;
+        }
+        putSequence(out, input.substr(anchor, position - anchor), position - match, length);
+        position += length;
+        anchor = position;
+    }
+    putSequence(out, input.substr(anchor), 0, 0);
+    return out;
+}
+
+// Returns false on malformed input
+inline bool decompress(std::string_view input, std::string& out) {
+    size_t i = 0;
+    auto getLength = [&](size_t length) {
+        for (unsigned char more = 255; more == 255 && i < input.size(); length += more) {
+            more = static_cast<unsigned char>(input[i++]);
+        }
+        return length;
+    };
+    out.clear();
+    while (i < input.size()) {
+        auto token = static_cast<unsigned char>(input[i++]);
+        size_t literals = token >> 4;
+        if (literals == 15) {
+            literals = getLength(literals);
+        }
+        if (literals > input.size() - i) {
+            return false;
+        }
+        out.append(input.substr(i, literals));
+        i += literals;
+        if (i == input.size()) {
+            return true;  // The final, literals-only sequence
+        }
+        if (input.size() - i < 2) {
+            return false;
+        }
+        size_t offset = static_cast<unsigned char>(input[i]) | static_cast<unsigned char>(input[i + 1]) << 8;
+        i += 2;
+        size_t length = token & 15;
+        if (length == 15) {
+            length = getLength(length);
+        }
+        length += 4;
+        if (offset == 0 || offset > out.size()) {
+            return false;
+        }
+        for (size_t from = out.size() - offset; length-- > 0;) {  // Byte by byte: matches may overlap
+            out.push_back(out[from++]);
+        }
+    }
+    return true;
+}
+}  // namespace lz
+
+// An append-only, memory-mapped file holding compressed history that no
+// longer fits the RAM budget. The file is anonymous (O_TMPFILE, or mkstemp()
+// and an immediate unlink where that is unsupported), so every segment gets
+// its own inode and it disappears with the process; its pages are written
+// back by the kernel and fault in again when undo reaches them.
+class SpillSegment {
+private:
+    int fd = -1;
+    char* mapping = nullptr;
+    size_t capacity = 0;
+    size_t end = 0;
+
+    static std::runtime_error systemError(const std::string& what) {
+        return std::runtime_error("SpillSegment: " + what + ": " + std::strerror(errno));
+    }
+
+    void grow(size_t needed) {
+        size_t newCapacity = std::max({needed, capacity * 2, size_t(1) << 20});
+        if (ftruncate(fd, static_cast<off_t>(newCapacity)) != 0) {
+            throw systemError("ftruncate");
+        }
+        void* grown = mapping ? mremap(mapping, capacity, newCapacity, MREMAP_MAYMOVE)
+                              : mmap(nullptr, newCapacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (grown == MAP_FAILED) {
+            throw systemError("mmap");
+        }
+        mapping = static_cast<char*>(grown);
+        capacity = newCapacity;
+    }
+
+public:
+    explicit SpillSegment(const std::string& directory) {
+#ifdef O_TMPFILE
+        fd = open(directory.c_str(), O_RDWR | O_TMPFILE | O_CLOEXEC, 0600);
+#endif
+        if (fd < 0) {
+            std::string path = (std::filesystem::path(directory) / "editor_history_XXXXXX").string();
+            fd = mkostemp(path.data(), O_CLOEXEC);
+            if (fd < 0) {
+                throw systemError("create spill file in " + directory);
+            }
+            unlink(path.c_str());
+        }
+    }
+
+    ~SpillSegment() {
+        if (mapping) {
+            munmap(mapping, capacity);
+        }
+        close(fd);
+    }
+
+    SpillSegment(const SpillSegment&) = delete;
+    SpillSegment& operator=(const SpillSegment&) = delete;
+
+    size_t append(std::string_view bytes) {
+        if (end + bytes.size() > capacity) {
+            grow(end + bytes.size());
+        }
+        std::memcpy(mapping + end, bytes.data(), bytes.size());
+        size_t offset = end;
+        end += bytes.size();
+        return offset;
+    }
+
+    std::string_view read(size_t offset, size_t length) const {
+        return std::string_view(mapping + offset, length);
+    }
+
+    // Spilled blocks are released newest first, so the end just moves back
+    void truncate(size_t offset) {
+        end = std::min(end, offset);
+    }
+
+    // Write the segment back and drop it from the page cache, so the next
+    // read comes from disk
+    void dropFromMemory() {
+        if (mapping && end > 0) {
+            msync(mapping, end, MS_SYNC);
+            madvise(mapping, capacity, MADV_DONTNEED);
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        }
+    }
+
+    size_t size() const {
+        return end;
+    }
+
+    size_t residentBytes() const {
+        if (!mapping || end == 0) {
+            return 0;
+        }
+        size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        std::vector<unsigned char> pages((end + page - 1) / page);
+        if (mincore(mapping, end, pages.data()) != 0) {
+            return 0;
+        }
+        size_t resident = 0;
+        for (unsigned char flags : pages) {
+            resident += (flags & 1) ? page : 0;
+        }
+        return std::min(resident, end);
+    }
+};
+
+// How much history stays live, and where the rest goes
+struct HistoryBudget {
+    size_t hotEntries = 256;           // Newest mementos kept as live snapshots
+    size_t blockEntries = 64;          // Older entries are compressed this many at a time
+    size_t coldBytes = size_t(1) << 20;  // Compressed blocks kept in RAM before spilling
+    std::string spillDirectory = std::filesystem::temp_directory_path().string();
+};
+
+struct HistoryStats {
+    size_t hotEntries = 0;
+    size_t coldEntries = 0;     // Compressed, in RAM
+    size_t spilledEntries = 0;  // Compressed, in the segment file
+    size_t hotBytes = 0;        // Nodes and chunks unique to the history's snapshots
+    size_t coldBytes = 0;       // Compressed blocks and undo's decoded patches in RAM
+    size_t rawColdBytes = 0;    // What the compressed blocks held before compression
+    size_t spilledBytes = 0;
+    size_t spilledResidentBytes = 0;
+};
+
+// Where the state undo() just exposed came from
+enum class HistoryTier { Hot, Cold, Spilled };
+
+// The newest budget.hotEntries mementos stay live. Beyond that, a background
+// task turns the oldest blockEntries of them into one compressed block of
+// patches, each rebuilding an entry from the one above it, and the mementos
+// are released. Once compressed blocks pass budget.coldBytes, the oldest
+// spill to a segment file. undo() pops the live top entry and, if the entry
+// below it was compressed, rebuilds it from the popped state by one patch.
+// Only the block undo is working through keeps its patches decoded, and they
+// count against budget.coldBytes: compressed blocks spill first, and if the
+// patches alone still exceed the budget they are dropped after each step and
+// decoded again by the next. peek() decodes into a temporary.
 class EditorHistory {
 private:
-    std::stack<std::unique_ptr<EditorMemento>> history;
+    struct Entry {
+        uint64_t serial;
+        std::unique_ptr<EditorMemento> memento;  // Null while compressed
+    };
+
+    struct ColdBlock {
+        size_t first;
+        size_t count;  // Entries [first, first + count)
+        size_t rawBytes;
+        std::string compressed;  // Empty once spilled
+        bool spilled = false;
+        size_t spillOffset = 0;
+        size_t spillLength = 0;
+        std::vector<TextPatch> patches;  // Decoded by undo() while this is the newest block
+    };
+
+    struct Compaction {
+        size_t first;
+        std::vector<uint64_t> serials;  // The block's entries, then the entry above them
+        std::string compressed;
+        size_t rawBytes;
+    };
+
+    HistoryBudget budget;
+    std::vector<Entry> entries;
+    std::deque<ColdBlock> blocks;  // Oldest first; together they cover entries [0, hotBegin())
+    uint64_t nextSerial = 0;
+    size_t coldRamBytes = 0;
+    std::unique_ptr<SpillSegment> segment;
+    std::future<Compaction> compaction;
+    HistoryTier lastTier = HistoryTier::Hot;
+
+    size_t hotBegin() const {
+        return blocks.empty() ? 0 : blocks.back().first + blocks.back().count;
+    }
+
+    static void putVarint(std::string& out, size_t value) {
+        for (; value >= 0x80; value >>= 7) {
+            out.push_back(char(value | 0x80));
+        }
+        out.push_back(char(value));
+    }
+
+    static size_t getVarint(std::string_view in, size_t& i) {
+        size_t value = 0;
+        for (int shift = 0; i < in.size(); shift += 7) {
+            auto byte = static_cast<unsigned char>(in[i++]);
+            value |= size_t(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                break;
+            }
+        }
+        return value;
+    }
+
+    // Runs on a background thread; the snapshots are immutable, so sharing
+    // them with the editor is safe
+    static Compaction compress(size_t first, std::vector<uint64_t> serials, std::vector<PersistentText> states) {
+        std::string raw;
+        for (size_t k = 0; k + 1 < states.size(); ++k) {
+            TextPatch patch = PersistentText::patchBetween(states[k + 1], states[k]);
+            putVarint(raw, patch.offset);
+            putVarint(raw, patch.removed);
+            putVarint(raw, patch.inserted.size());
+            raw += patch.inserted;
+        }
+        return {first, std::move(serials), lz::compress(raw), raw.size()};
+    }
+
+    static size_t patchBytes(const TextPatch& patch) {
+        return sizeof(TextPatch) + patch.inserted.capacity();
+    }
+
+    std::vector<TextPatch> decode(const ColdBlock& block) const {
+        std::string_view source = block.spilled ? segment->read(block.spillOffset, block.spillLength)
+                                                : std::string_view(block.compressed);
+        std::string raw;
+        if (!lz::decompress(source, raw)) {
+            throw std::runtime_error("EditorHistory: corrupt history block");
+        }
+        size_t i = 0;
+        std::vector<TextPatch> patches(block.count);
+        for (TextPatch& patch : patches) {
+            patch.offset = getVarint(raw, i);
+            patch.removed = getVarint(raw, i);
+            size_t length = getVarint(raw, i);
+            patch.inserted.assign(raw, i, length);
+            i += length;
+        }
+        return patches;
+    }
+
+    // Cache the newest block's patches for the undo steps through it. The
+    // compressed bytes stay, so the cache can be dropped at any time.
+    void decodeForUndo(ColdBlock& block) {
+        if (!block.patches.empty()) {
+            return;
+        }
+        block.patches = decode(block);
+        for (const TextPatch& patch : block.patches) {
+            coldRamBytes += patchBytes(patch);
+        }
+    }
+
+    void dropPatches(ColdBlock& block) {
+        for (const TextPatch& patch : block.patches) {
+            coldRamBytes -= patchBytes(patch);
+        }
+        block.patches = std::vector<TextPatch>();
+    }
+
+    void release(ColdBlock& block) {
+        if (block.spilled) {
+            segment->truncate(block.spillOffset);
+        } else {
+            coldRamBytes -= block.compressed.size();
+        }
+    }
+
+    // Install a finished compaction if its entries are still the ones it read
+    void collect(bool wait) {
+        if (!compaction.valid() ||
+            (!wait && compaction.wait_for(std::chrono::seconds(0)) != std::future_status::ready)) {
+            return;
+        }
+        Compaction done = compaction.get();
+        size_t count = done.serials.size() - 1;
+        bool current = done.first == hotBegin() && done.first + count < entries.size();
+        for (size_t k = 0; current && k <= count; ++k) {
+            current = entries[done.first + k].serial == done.serials[k];
+        }
+        if (!current) {
+            return;  // Undo reached those entries first
+        }
+        for (size_t k = 0; k < count; ++k) {
+            entries[done.first + k].memento.reset();
+        }
+        coldRamBytes += done.compressed.size();
+        if (!blocks.empty()) {
+            dropPatches(blocks.back());  // Undo reaches the new block first
+        }
+        ColdBlock& block = blocks.emplace_back();
+        block.first = done.first;
+        block.count = count;
+        block.rawBytes = done.rawBytes;
+        block.compressed = std::move(done.compressed);
+        enforceBudget();
+    }
+
+    // Spill compressed blocks, oldest first, then give up the undo cache
+    void enforceBudget() {
+        for (ColdBlock& oldest : blocks) {
+            if (coldRamBytes <= budget.coldBytes) {
+                break;
+            }
+            if (oldest.spilled) {
+                continue;
+            }
+            if (!segment) {
+                segment = std::make_unique<SpillSegment>(budget.spillDirectory);
+            }
+            oldest.spillLength = oldest.compressed.size();
+            oldest.spillOffset = segment->append(oldest.compressed);
+            oldest.spilled = true;
+            coldRamBytes -= oldest.spillLength;
+            oldest.compressed = std::string();
+        }
+        if (coldRamBytes > budget.coldBytes && !blocks.empty()) {
+            dropPatches(blocks.back());
+        }
+    }
+
+    void startCompaction() {
+        size_t first = hotBegin();
+        if (compaction.valid() || entries.size() - first < budget.hotEntries + budget.blockEntries) {
+            return;
+        }
+        std::vector<uint64_t> serials;
+        std::vector<PersistentText> states;
+        for (size_t k = first; k <= first + budget.blockEntries; ++k) {
+            serials.push_back(entries[k].serial);
+            states.push_back(entries[k].memento->getState());
+        }
+        compaction = std::async(std::launch::async, &EditorHistory::compress, first, std::move(serials),
+                                std::move(states));
+    }
 
 public:
+    explicit EditorHistory(HistoryBudget budget = HistoryBudget()) : budget(std::move(budget)) {
+        this->budget.hotEntries = std::max<size_t>(1, this->budget.hotEntries);
+        this->budget.blockEntries = std::max<size_t>(1, this->budget.blockEntries);
+    }
+
     void save(std::unique_ptr<EditorMemento> memento) {
-        history.push(std::move(memento));
+        entries.push_back({nextSerial++, std::move(memento)});
+        collect(false);
+        startCompaction();
     }
 
     std::unique_ptr<EditorMemento> undo() {
-        if (history.empty()) {
+        if (entries.empty()) {
             std::cout << "No states to undo!" << std::endl;
             return nullptr;
         }
 
-        auto lastState = std::move(history.top());
-        history.pop();
+        auto lastState = std::move(entries.back().memento);
+        entries.pop_back();
+        lastTier = HistoryTier::Hot;
+        if (!entries.empty() && !entries.back().memento) {
+            // The new top was compressed: rebuild it from the state above
+            ColdBlock& block = blocks.back();
+            lastTier = block.spilled ? HistoryTier::Spilled : HistoryTier::Cold;
+            decodeForUndo(block);
+            size_t index = entries.size() - 1;
+            const TextPatch& patch = block.patches[index - block.first];
+            entries.back().memento = std::make_unique<EditorMemento>(lastState->getState().applied(patch));
+            coldRamBytes -= patchBytes(block.patches.back());
+            block.patches.pop_back();
+            if (--block.count == 0) {
+                release(block);
+                blocks.pop_back();
+            } else {
+                enforceBudget();
+            }
+        }
         return lastState;
     }
+
+    // Where the entry exposed by the last undo() was stored
+    HistoryTier lastUndoTier() const {
+        return lastTier;
+    }
+
+    // The state saved at index (0 is the oldest), rebuilt if it was compressed
+    std::unique_ptr<EditorMemento> peek(size_t index) {
+        if (index >= entries.size()) {
+            return nullptr;
+        }
+        if (entries[index].memento) {
+            return std::make_unique<EditorMemento>(entries[index].memento->getState());
+        }
+        PersistentText state = entries[hotBegin()].memento->getState();
+        std::vector<TextPatch> decoded;
+        for (size_t b = blocks.size(); b-- > 0;) {
+            const ColdBlock& block = blocks[b];
+            if (block.patches.empty()) {
+                decoded = decode(block);
+            }
+            const std::vector<TextPatch>& patches = block.patches.empty() ? decoded : block.patches;
+            for (size_t k = block.count; k-- > 0;) {
+                state = state.applied(patches[k]);
+                if (block.first + k == index) {
+                    return std::make_unique<EditorMemento>(std::move(state));
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    size_t size() const {
+        return entries.size();
+    }
+
+    // Finish any background compression, so stats() reflects the budget
+    void settle() {
+        for (;;) {
+            collect(true);
+            startCompaction();
+            if (!compaction.valid()) {
+                return;
+            }
+        }
+    }
+
+    HistoryStats stats() const {
+        HistoryStats result;
+        std::unordered_set<const void*> seen;
+        for (const Entry& entry : entries) {
+            if (entry.memento) {
+                ++result.hotEntries;
+                result.hotBytes += sizeof(EditorMemento) + entry.memento->getState().newBytes(seen);
+            }
+        }
+        for (const ColdBlock& block : blocks) {
+            (block.spilled ? result.spilledEntries : result.coldEntries) += block.count;
+            result.rawColdBytes += block.rawBytes;
+        }
+        result.coldBytes += coldRamBytes;
+        result.spilledBytes = segment ? segment->size() : 0;
+        result.spilledResidentBytes = segment ? segment->residentBytes() : 0;
+        return result;
+    }
+
+    // For benchmarks: push spilled history out of the page cache
+    void dropSpilledPages() {
+        if (segment) {
+            segment->dropFromMemory();
+        }
+    }
 };
 
-// Step 4: Use the Memento pattern in client code
-int main() {
+// Step 5: A branching caretaker: undo, redo and jumps over a tree of states
+struct HistoryId {
+    uint32_t node = 0;
+    uint32_t generation = 0;
+};
+
+// Every save becomes a child of the current state, so typing after an undo
+// starts a new branch instead of discarding the old one. Nodes live in one
+// arena and point at their parent by index; undo follows that link and redo
+// follows the child it was last undone from, both O(1). Snapshots share
+// structure, so a node costs what its edit changed. Freed nodes go on a
+// free list for reuse, and bumping a node's generation when it is freed
+// makes stale ids fail to resolve instead of naming the node's next user.
+// The mementos undo(), redo(), jumpTo() and find() return point into the
+// arena: they stay valid only until the next save(), which may reallocate
+// it, or collectGarbage(), which may free them. Restore from them or copy
+// their state right away, and keep a HistoryId to come back later.
+class EditorHistoryTree {
+private:
+    static constexpr uint32_t None = UINT32_MAX;
+
+    struct Node {
+        EditorMemento memento;
+        uint32_t parent;
+        uint32_t redoChild;  // The child to redo into, None if there is none
+        uint32_t generation;
+        bool live;
+        bool pinned;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<uint32_t> freeNodes;
+    uint32_t current = None;
+    size_t liveCount = 0;
+
+    const Node* resolve(HistoryId id) const {
+        if (id.node >= nodes.size() || !nodes[id.node].live || nodes[id.node].generation != id.generation) {
+            return nullptr;
+        }
+        return &nodes[id.node];
+    }
+
+    HistoryId idOf(uint32_t node) const {
+        return {node, nodes[node].generation};
+    }
+
+public:
+    // Add a state as a child of the current one and move to it
+    HistoryId save(std::unique_ptr<EditorMemento> memento) {
+        uint32_t node;
+        if (!freeNodes.empty()) {
+            node = freeNodes.back();
+            freeNodes.pop_back();
+            Node& reused = nodes[node];
+            reused.memento = std::move(*memento);
+            reused.parent = current;
+            reused.redoChild = None;
+            reused.live = true;
+            reused.pinned = false;
+        } else {
+            node = static_cast<uint32_t>(nodes.size());
+            nodes.push_back({std::move(*memento), current, None, 0, true, false});
+        }
+        if (current != None) {
+            nodes[current].redoChild = node;
+        }
+        current = node;
+        ++liveCount;
+        return idOf(node);
+    }
+
+    // Move to the parent state and return it, or nullptr at the root
+    const EditorMemento* undo() {
+        if (!canUndo()) {
+            std::cout << "No states to undo!" << std::endl;
+            return nullptr;
+        }
+        uint32_t parent = nodes[current].parent;
+        nodes[parent].redoChild = current;
+        current = parent;
+        return &nodes[current].memento;
+    }
+
+    // Move back down the branch last undone from, or save()d into
+    const EditorMemento* redo() {
+        if (!canRedo()) {
+            std::cout << "No states to redo!" << std::endl;
+            return nullptr;
+        }
+        current = nodes[current].redoChild;
+        return &nodes[current].memento;
+    }
+
+    // Make any saved state current, on this branch or another
+    const EditorMemento* jumpTo(HistoryId id) {
+        if (!resolve(id)) {
+            return nullptr;
+        }
+        current = id.node;
+        return &nodes[current].memento;
+    }
+
+    bool canUndo() const {
+        return current != None && nodes[current].parent != None;
+    }
+
+    bool canRedo() const {
+        return current != None && nodes[current].redoChild != None;
+    }
+
+    HistoryId currentId() const {
+        return current == None ? HistoryId{None, 0} : idOf(current);
+    }
+
+    HistoryId parentOf(HistoryId id) const {
+        const Node* node = resolve(id);
+        return node && node->parent != None ? idOf(node->parent) : HistoryId{None, 0};
+    }
+
+    // The state an id names, or nullptr once it has been collected
+    const EditorMemento* find(HistoryId id) const {
+        const Node* node = resolve(id);
+        return node ? &node->memento : nullptr;
+    }
+
+    // Pinned states, and the states leading to them, survive collectGarbage()
+    bool pin(HistoryId id, bool pinned = true) {
+        if (!resolve(id)) {
+            return false;
+        }
+        nodes[id.node].pinned = pinned;
+        return true;
+    }
+
+    // Free every state that is not on the path from the root to the current
+    // state, on its redo chain, or on the path to a pinned state. Returns
+    // the number of states freed.
+    size_t collectGarbage() {
+        std::vector<bool> reachable(nodes.size(), false);
+        auto markPath = [&](uint32_t node) {
+            for (; node != None && !reachable[node]; node = nodes[node].parent) {
+                reachable[node] = true;
+            }
+        };
+        uint32_t tip = current;
+        while (tip != None && nodes[tip].redoChild != None) {
+            tip = nodes[tip].redoChild;
+        }
+        markPath(tip);
+        for (uint32_t node = 0; node < nodes.size(); ++node) {
+            if (nodes[node].live && nodes[node].pinned) {
+                markPath(node);
+            }
+        }
+
+        size_t freed = 0;
+        for (uint32_t node = 0; node < nodes.size(); ++node) {
+            Node& entry = nodes[node];
+            if (!entry.live) {
+                continue;
+            }
+            if (!reachable[node]) {
+                entry.memento = EditorMemento(PersistentText());
+                entry.live = false;
+                ++entry.generation;
+                freeNodes.push_back(node);
+                ++freed;
+            } else if (entry.redoChild != None && !reachable[entry.redoChild]) {
+                entry.redoChild = None;
+            }
+        }
+        liveCount -= freed;
+        return freed;
+    }
+
+    size_t size() const {
+        return liveCount;
+    }
+
+    // Heap bytes of the arena and of the text the saved states hold
+    size_t bytesUsed() const {
+        std::unordered_set<const void*> seen;
+        size_t bytes = nodes.capacity() * sizeof(Node) + freeNodes.capacity() * sizeof(uint32_t);
+        for (const Node& node : nodes) {
+            if (node.live) {
+                bytes += node.memento.getState().newBytes(seen);
+            }
+        }
+        return bytes;
+    }
+};
+
+// Step 6: Benchmark history size and latency on a large document
+uint64_t fingerprint(const std::string& text) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : text) {
+        hash = (hash ^ c) * 1099511628211ull;
+    }
+    return hash;
+}
+
+void benchmarkSnapshotHistory(size_t documentBytes, size_t snapshots) {
+    std::string paragraph = "The quick brown fox jumps over the lazy dog. ";
+    std::string text;
+    text.reserve(documentBytes + paragraph.size());
+    while (text.size() < documentBytes) {
+        text += paragraph;
+    }
+    TextEditor editor;
+    editor.type(text);
+    uint64_t originalFingerprint = fingerprint(text);
+    text.clear();
+    text.shrink_to_fit();
+
+    uint64_t state = 88172645463325252ull;
+    auto nextRandom = [&state] {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    };
+    // A mix of appends, inserts and deletes anywhere in the document
+    auto edit = [&] {
+        switch (nextRandom() % 3) {
+        case 0:
+            editor.type("more text ");
+            break;
+        case 1:
+            editor.insert(nextRandom() % editor.size(), "inserted ");
+            break;
+        default:
+            editor.erase(nextRandom() % editor.size(), 12);
+            break;
+        }
+    };
+    auto seconds = [](auto start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    // A string-copy memento per save: time a sample and extrapolate the memory
+    const size_t sample = std::min<size_t>(snapshots, 50);
+    std::vector<std::string> copies;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < sample; ++i) {
+        copies.push_back(editor.getContent());
+    }
+    double copySeconds = seconds(start);
+    copies.clear();
+
+    // Keep 256 live snapshots and 16 KB of compressed history in RAM; the
+    // rest spills to disk
+    HistoryBudget budget;
+    budget.coldBytes = 16 * 1024;
+    EditorHistory history(budget);
+    history.save(editor.save());
+    std::vector<std::pair<size_t, uint64_t>> checkpoints;  // Fingerprints of a few saved states
+    double editSeconds = 0;
+    double saveSeconds = 0;
+    for (size_t i = 1; i <= snapshots; ++i) {
+        start = std::chrono::steady_clock::now();
+        edit();
+        editSeconds += seconds(start);
+        start = std::chrono::steady_clock::now();
+        history.save(editor.save());
+        saveSeconds += seconds(start);
+        if (i % (snapshots / 16 + 1) == 0) {
+            checkpoints.emplace_back(i, fingerprint(editor.getContent()));
+        }
+    }
+    history.settle();
+    HistoryStats stats = history.stats();
+
+    // Undo everything with the spilled history out of the page cache, timing
+    // each step by where the state it exposed was kept. Nothing is peeked
+    // first, so every block is decoded by the undo being timed; checkpoints
+    // are compared as undo passes them, outside the timed region.
+    history.dropSpilledPages();
+    size_t residentAfterDrop = history.stats().spilledResidentBytes;
+    double tierSeconds[3] = {};
+    double tierWorst[3] = {};
+    size_t tierCount[3] = {};
+    bool matches = true;
+    while (history.size() > 1) {
+        start = std::chrono::steady_clock::now();
+        auto memento = history.undo();
+        editor.restore(*memento);
+        double elapsed = seconds(start);
+        auto tier = static_cast<size_t>(history.lastUndoTier());
+        tierSeconds[tier] += elapsed;
+        tierWorst[tier] = std::max(tierWorst[tier], elapsed);
+        ++tierCount[tier];
+        while (!checkpoints.empty() && checkpoints.back().first == history.size()) {
+            matches = matches && fingerprint(editor.getContent()) == checkpoints.back().second;
+            checkpoints.pop_back();
+        }
+    }
+    matches = matches && checkpoints.empty();
+    editor.restore(*history.peek(0));
+    matches = matches && fingerprint(editor.getContent()) == originalFingerprint;
+
+    std::cout << documentBytes / 1e6 << " MB document, " << snapshots << " snapshots:" << std::endl;
+    std::cout << "String copies:     " << double(snapshots) * documentBytes / 1e9
+              << " GB of history (extrapolated), " << copySeconds * 1e3 / sample << " ms/save" << std::endl;
+    std::cout << "Persistent text:   " << saveSeconds * 1e9 / snapshots << " ns/save, "
+              << editSeconds * 1e6 / snapshots << " us/edit" << (matches ? "" : " MISMATCH") << std::endl;
+    std::cout << "  live:            " << stats.hotEntries << " entries, " << stats.hotBytes / 1e6 << " MB"
+              << std::endl;
+    std::cout << "  compressed:      " << stats.coldEntries << " entries, " << stats.coldBytes / 1e3 << " KB in RAM"
+              << std::endl;
+    std::cout << "  spilled:         " << stats.spilledEntries << " entries, " << stats.spilledBytes / 1e3
+              << " KB on disk, " << residentAfterDrop / 1e3 << " KB resident after drop" << std::endl;
+    std::cout << "  compression:     " << stats.rawColdBytes / 1e3 << " KB of patches -> "
+              << (stats.coldBytes + stats.spilledBytes) / 1e3 << " KB" << std::endl;
+    const char* tierNames[3] = {"live", "compressed", "spilled"};
+    for (size_t tier = 0; tier < 3; ++tier) {
+        if (tierCount[tier] > 0) {
+            std::cout << "  undo into " << tierNames[tier] << ": " << tierCount[tier] << " steps, "
+                      << tierSeconds[tier] * 1e6 / tierCount[tier] << " us mean, " << tierWorst[tier] * 1e6
+                      << " us worst" << std::endl;
+        }
+    }
+}
+
+// A long branching session: edits, undos, redos and jumps to earlier states,
+// then a collection of the branches left behind
+void benchmarkHistoryTree(size_t documentBytes, size_t operations) {
+    TextEditor editor;
+    editor.type(std::string(documentBytes, 'x'));
+    EditorHistoryTree history;
+    std::vector<HistoryId> saved{history.save(editor.save())};
+    std::vector<std::pair<HistoryId, uint64_t>> checkpoints;  // Fingerprints of a few saved states
+
+    uint64_t state = 88172645463325252ull;
+    auto nextRandom = [&state] {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    };
+    auto seconds = [](auto start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    double opSeconds[4] = {};  // save, undo, redo, jump; each with its restore
+    size_t opCount[4] = {};
+    for (size_t i = 0; i < operations; ++i) {
+        size_t op = nextRandom() % 10;
+        op = op < 5 ? 0 : op < 8 ? 1 : op < 9 ? 2 : 3;
+        if ((op == 1 && !history.canUndo()) || (op == 2 && !history.canRedo())) {
+            op = 0;
+        }
+        if (op == 0) {
+            editor.insert(nextRandom() % editor.size(), "edit ");
+        }
+        auto start = std::chrono::steady_clock::now();
+        const EditorMemento* memento = nullptr;
+        switch (op) {
+        case 0:
+            saved.push_back(history.save(editor.save()));
+            break;
+        case 1:
+            memento = history.undo();
+            break;
+        case 2:
+            memento = history.redo();
+            break;
+        default:
+            memento = history.jumpTo(saved[nextRandom() % saved.size()]);
+            break;
+        }
+        if (memento) {
+            editor.restore(*memento);
+        }
+        opSeconds[op] += seconds(start);
+        ++opCount[op];
+        if (op == 0 && saved.size() % (operations / 64 + 1) == 0) {
+            checkpoints.emplace_back(saved.back(), fingerprint(editor.getContent()));
+            history.pin(saved.back());
+        }
+    }
+
+    bool matches = true;
+    for (auto [id, hash] : checkpoints) {
+        matches = matches && fingerprint(history.find(id)->getState().toString()) == hash;
+    }
+    size_t nodesBefore = history.size();
+    size_t bytesBefore = history.bytesUsed();
+    auto start = std::chrono::steady_clock::now();
+    size_t freed = history.collectGarbage();
+    double collectSeconds = seconds(start);
+    size_t survivors = 0;
+    for (HistoryId id : saved) {
+        survivors += history.find(id) != nullptr;
+    }
+    for (auto [id, hash] : checkpoints) {
+        matches = matches && fingerprint(history.jumpTo(id)->getState().toString()) == hash;
+    }
+    matches = matches && survivors == history.size();
+
+    std::cout << documentBytes / 1e6 << " MB document, " << operations << " operations on a history tree:"
+              << std::endl;
+    const char* names[4] = {"save", "undo", "redo", "jump"};
+    for (size_t op = 0; op < 4; ++op) {
+        std::cout << "  " << names[op] << ": " << opCount[op] << " x " << opSeconds[op] * 1e9 / opCount[op]
+                  << " ns" << std::endl;
+    }
+    std::cout << "  collect: " << freed << " of " << nodesBefore << " states freed in " << collectSeconds * 1e3
+              << " ms, " << bytesBefore / 1e6 << " -> " << history.bytesUsed() / 1e6 << " MB"
+              << (matches ? "" : " MISMATCH") << std::endl;
+}
+
+// Step 7: Use the Memento pattern in client code
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        size_t snapshots = argc > 2 ? std::stoul(argv[2]) : 10000;
+        benchmarkSnapshotHistory(10 * 1000 * 1000, snapshots);
+        benchmarkHistoryTree(10 * 1000 * 1000, snapshots * 10);
+        return 0;
+    }
+
     TextEditor editor;
     EditorHistory history;
 
@@ -89,5 +1340,24 @@ int main() {
     }
     std::cout << "After second undo: " << editor.getContent() << std::endl;  // Output: (empty)
 
+    // A history tree keeps the branch an undo leaves behind
+    TextEditor draft;
+    EditorHistoryTree tree;
+    draft.type("Hello, ");
+    tree.save(draft.save());
+    draft.type("World!");
+    HistoryId world = tree.save(draft.save());
+    draft.restore(*tree.undo());
+    draft.type("there!");
+    tree.save(draft.save());
+    std::cout << "New branch: " << draft.getContent() << std::endl;  // Output: Hello, there!
+
+    draft.restore(*tree.jumpTo(world));
+    std::cout << "Jump back: " << draft.getContent() << std::endl;  // Output: Hello, World!
+
+    draft.restore(*tree.undo());
+    draft.restore(*tree.redo());
+    std::cout << "Undo and redo: " << draft.getContent() << std::endl;  // Output: Hello, World!
+
     return 0;
 }
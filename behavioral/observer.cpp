@@ -1,6 +1,16 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <iostream>
-#include <vector>
+#include <iterator>
 #include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 // Step 1: Define the Observer interface
 class StockObserver {
@@ -9,42 +19,256 @@ public:
     virtual void update(float price) = 0;
 };
 
-// Step 2: Define the Subject (Stock) class
+// Step 2: Epoch-based reclamation, so readers never lock or touch refcounts
+// A reader announces the epoch it started in. An object unlinked in epoch r
+// can only still be held by readers that announced r or earlier, so it is
+// freed once every thread is idle or has announced a later epoch.
+class EpochDomain {
+public:
+    struct Retired {
+        virtual ~Retired() = default;
+        Retired* nextRetired = nullptr;
+        uint64_t retireEpoch = 0;
+    };
+
+private:
+    static constexpr size_t MaxThreads = 256;
+    static constexpr uint64_t Idle = UINT64_MAX;
+
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> epoch{Idle};
+        std::atomic<bool> claimed{false};
+    };
+
+    // Each thread claims a slot on first use and gives it back when it exits
+    struct ThreadSlot {
+        Slot* slot = nullptr;
+        size_t depth = 0;  // Nested critical sections announce only once
+
+        ~ThreadSlot() {
+            if (slot) {
+                slot->claimed.store(false, std::memory_order_release);
+            }
+        }
+    };
+
+    std::atomic<uint64_t> globalEpoch{1};
+    std::atomic<size_t> slotsUsed{0};  // High-water mark of claimed slots
+    Slot slots[MaxThreads];
+    std::atomic<Retired*> retired{nullptr};
+
+    EpochDomain() = default;
+
+    ThreadSlot& threadSlot() {
+        thread_local ThreadSlot local;
+        if (!local.slot) {
+            for (size_t i = 0; i < MaxThreads && !local.slot; ++i) {
+                if (!slots[i].claimed.exchange(true, std::memory_order_acquire)) {
+                    local.slot = &slots[i];
+                    size_t used = slotsUsed.load();
+                    while (used < i + 1 && !slotsUsed.compare_exchange_weak(used, i + 1)) {
+                    }
+                }
+            }
+            if (!local.slot) {
+                throw std::runtime_error("EpochDomain: more than " + std::to_string(MaxThreads) + " threads");
+            }
+        }
+        return local;
+    }
+
+    uint64_t oldestActive() const {
+        uint64_t oldest = Idle;
+        size_t used = slotsUsed.load();
+        for (size_t i = 0; i < used; ++i) {
+            oldest = std::min(oldest, slots[i].epoch.load());
+        }
+        return oldest;
+    }
+
+    void pushRetired(Retired* first, Retired* last) {
+        Retired* head = retired.load(std::memory_order_relaxed);
+        do {
+            last->nextRetired = head;
+        } while (!retired.compare_exchange_weak(head, first, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+public:
+    static EpochDomain& instance() {
+        static EpochDomain domain;
+        return domain;
+    }
+
+    ~EpochDomain() {
+        for (Retired* object = retired.load(); object;) {
+            delete std::exchange(object, object->nextRetired);
+        }
+    }
+
+    EpochDomain(const EpochDomain&) = delete;
+    EpochDomain& operator=(const EpochDomain&) = delete;
+
+    void enter() {
+        ThreadSlot& local = threadSlot();
+        if (local.depth++ == 0) {
+            local.slot->epoch.store(globalEpoch.load());
+        }
+    }
+
+    void exit() {
+        ThreadSlot& local = threadSlot();
+        if (--local.depth == 0) {
+            local.slot->epoch.store(Idle, std::memory_order_release);
+        }
+    }
+
+    // Hand over an object that has just been unlinked; it is deleted once
+    // no reader can still hold it
+    void retire(Retired* object) {
+        object->retireEpoch = globalEpoch.fetch_add(1);
+        pushRetired(object, object);
+    }
+
+    // Delete whatever retired objects are no longer reachable by any reader
+    void reclaim() {
+        Retired* list = retired.exchange(nullptr, std::memory_order_acquire);
+        if (!list) {
+            return;
+        }
+        uint64_t oldest = oldestActive();
+        Retired* keepFirst = nullptr;
+        Retired* keepLast = nullptr;
+        while (list) {
+            Retired* object = std::exchange(list, list->nextRetired);
+            if (object->retireEpoch < oldest) {
+                delete object;
+            } else {
+                object->nextRetired = keepFirst;
+                keepFirst = object;
+                keepLast = keepLast ? keepLast : object;
+            }
+        }
+        if (keepFirst) {
+            pushRetired(keepFirst, keepLast);
+        }
+    }
+
+    // Wait for every reader that started before this call to finish. Must
+    // not be called from inside a critical section.
+    void synchronize() {
+        uint64_t epoch = globalEpoch.fetch_add(1);
+        while (oldestActive() <= epoch) {
+            std::this_thread::yield();
+        }
+        reclaim();
+    }
+};
+
+class EpochGuard {
+public:
+    EpochGuard() {
+        EpochDomain::instance().enter();
+    }
+
+    ~EpochGuard() {
+        EpochDomain::instance().exit();
+    }
+
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+};
+
+// Step 3: Define the Subject (Stock) class
+// The observer list is an immutable snapshot behind an atomic pointer.
+// attach and detach copy it, change the copy and swap it in with a
+// compare-and-swap, retrying if another writer got there first; the old
+// snapshot is retired to the epoch domain. notify and setPrice take no
+// lock and touch no refcount, so any number of threads can call them while
+// observers come and go. Observers may therefore be updated from several
+// threads at once, and may still see one update from a notify already in
+// flight when detach returns; call synchronize() to wait those out.
 class Stock {
 private:
-    std::vector<std::shared_ptr<StockObserver>> observers;
-    float price;
+    struct Snapshot : EpochDomain::Retired {
+        std::vector<std::shared_ptr<StockObserver>> observers;
+    };
+
+    std::atomic<Snapshot*> observers{new Snapshot};
+    std::atomic<float> price{0};
+
+    template <typename Change>
+    void publish(Change change) {
+        auto next = std::make_unique<Snapshot>();
+        Snapshot* current;
+        {
+            EpochGuard guard;  // Keeps current alive while it is copied
+            current = observers.load();
+            do {
+                next->observers.clear();
+                change(current->observers, next->observers);
+            } while (!observers.compare_exchange_weak(current, next.get()));
+        }
+        next.release();
+        EpochDomain::instance().retire(current);
+        EpochDomain::instance().reclaim();
+    }
+
+    void notify(float newPrice) const {
+        EpochGuard guard;
+        for (const auto& observer : observers.load()->observers) {
+            observer->update(newPrice);
+        }
+    }
 
 public:
+    Stock() = default;
+
+    ~Stock() {
+        delete observers.load();
+    }
+
+    Stock(const Stock&) = delete;
+    Stock& operator=(const Stock&) = delete;
+
     // Register an observer
     void attach(std::shared_ptr<StockObserver> observer) {
-        observers.push_back(observer);
+        publish([&observer](const auto& from, auto& to) {
+            to.reserve(from.size() + 1);
+            to.insert(to.end(), from.begin(), from.end());
+            to.push_back(observer);
+        });
     }
 
     // Unregister an observer
     void detach(std::shared_ptr<StockObserver> observer) {
-        observers.erase(std::remove(observers.begin(), observers.end(), observer), observers.end());
+        publish([&observer](const auto& from, auto& to) {
+            to.reserve(from.size());
+            std::remove_copy(from.begin(), from.end(), std::back_inserter(to), observer);
+        });
+    }
+
+    // Wait until no notify that started before this call is still running
+    void synchronize() const {
+        EpochDomain::instance().synchronize();
     }
 
     // Notify all observers about price change
-    void notify() {
-        for (auto& observer : observers) {
-            observer->update(price);
-        }
+    void notify() const {
+        notify(getPrice());
     }
 
     // Set the price and notify observers
     void setPrice(float newPrice) {
-        price = newPrice;
-        notify();
+        price.store(newPrice, std::memory_order_relaxed);
+        notify(newPrice);
     }
 
     float getPrice() const {
-        return price;
+        return price.load(std::memory_order_relaxed);
     }
 };
 
-// Step 3: Implement concrete observers
+// Step 4: Implement concrete observers
 class TradingAlgorithm : public StockObserver {
 public:
     void update(float price) override {
@@ -69,8 +293,112 @@ public:
     }
 };
 
-// Step 4: Use the Observer pattern in client code
-int main() {
+// Step 5: Benchmark notification throughput while observers come and go
+class CountingObserver : public StockObserver {
+public:
+    std::atomic<uint64_t> updates{0};
+
+    void update(float) override {
+        updates.fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+// The straightforward thread-safe subject, for comparison: one mutex held
+// across every notify
+class LockedStock {
+private:
+    std::vector<std::shared_ptr<StockObserver>> observers;
+    mutable std::mutex mutex;
+
+public:
+    void attach(std::shared_ptr<StockObserver> observer) {
+        std::lock_guard<std::mutex> lock(mutex);
+        observers.push_back(std::move(observer));
+    }
+
+    void detach(std::shared_ptr<StockObserver> observer) {
+        std::lock_guard<std::mutex> lock(mutex);
+        observers.erase(std::remove(observers.begin(), observers.end(), observer), observers.end());
+    }
+
+    void synchronize() const {}
+
+    void setPrice(float newPrice) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& observer : observers) {
+            observer->update(newPrice);
+        }
+    }
+};
+
+// Producers call setPrice at full rate on a subject with `steady` permanent
+// observers, while one thread keeps attaching and detaching another
+template <typename Subject>
+void benchmarkSubject(const char* name, size_t producers, size_t pricesEach, size_t steady) {
+    Subject stock;
+    std::vector<std::shared_ptr<CountingObserver>> permanent;
+    for (size_t i = 0; i < steady; ++i) {
+        permanent.push_back(std::make_shared<CountingObserver>());
+        stock.attach(permanent.back());
+    }
+
+    std::atomic<size_t> running{producers};
+    size_t churns = 0;
+    bool detachedQuiet = true;  // A detached observer gets nothing after synchronize()
+    std::thread churn([&] {
+        while (running.load(std::memory_order_relaxed) > 0) {
+            auto transient = std::make_shared<CountingObserver>();
+            stock.attach(transient);
+            std::this_thread::yield();
+            stock.detach(transient);
+            stock.synchronize();
+            uint64_t seen = transient->updates.load();
+            std::this_thread::yield();
+            detachedQuiet = detachedQuiet && transient->updates.load() == seen;
+            ++churns;
+        }
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p] {
+            for (size_t i = 0; i < pricesEach; ++i) {
+                stock.setPrice(float(p * pricesEach + i));
+            }
+            running.fetch_sub(1);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    churn.join();
+
+    bool complete = true;
+    for (auto& observer : permanent) {
+        complete = complete && observer->updates.load() == producers * pricesEach;
+    }
+    std::cout << name << producers * pricesEach / seconds / 1e6 << " M setPrice/s, "
+              << producers * pricesEach * steady / seconds / 1e6 << " M updates/s, " << churns
+              << " attach/detach pairs" << (complete && detachedQuiet ? "" : " MISMATCH") << std::endl;
+}
+
+void benchmarkObservers(size_t producers, size_t pricesEach, size_t steady) {
+    std::cout << producers << " producers x " << pricesEach << " prices, " << steady
+              << " observers, one thread attaching and detaching:" << std::endl;
+    benchmarkSubject<LockedStock>("Mutex:      ", producers, pricesEach, steady);
+    benchmarkSubject<Stock>("Epoch RCU:  ", producers, pricesEach, steady);
+}
+
+// Step 6: Use the Observer pattern in client code
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        size_t producers = argc > 2 ? std::stoul(argv[2]) : std::max(2u, std::thread::hardware_concurrency());
+        benchmarkObservers(producers, 1000000, 8);
+        return 0;
+    }
+
     Stock stock;
 
     // Create observers
@@ -95,6 +423,7 @@ int main() {
 //  The StockObserver interface ensures that all observers have an update method to handle notifications.
 //  Concrete observers (TradingAlgorithm, UserInterface, Logger) implement the update method with custom logic for how they should react to stock price changes.
 //  When the stock price is updated, all observers are automatically notified.
+//  The observer list is published as immutable snapshots, so prices can be set from many threads while observers are attached and detached.
 //  Advantages:
 //  Loose coupling: The subject does not need to know the details of its observers, and adding new observers or removing existing ones doesn’t require changing the subject.
 //  Scalability: You can add as many observers as needed without modifying the core logic of the subject.